@@ -0,0 +1,374 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ARENA_HAVE_MMAP 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h> // SYS_mbind (no libnuma dependency)
+#endif
+
+#define ARENA_NUM_CLASSES (ARENA_MAX_BLOCK / ARENA_ALIGN + 1)
+#define ARENA_SMALL_PAGE_SIZE 4096UL
+#define MPOL_BIND_MODE 2 // MPOL_BIND from <linux/mempolicy.h>
+
+// Backing type of a chunk, used for stats and for releasing it
+enum
+{
+    CHUNK_MALLOC = 0,
+    CHUNK_MMAP,
+    CHUNK_TRANSPARENT,
+    CHUNK_EXPLICIT
+};
+
+// One contiguous region obtained from the kernel
+typedef struct ArenaChunk
+{
+    char *base;
+    size_t size;
+    int kind;
+    int numa_bound;
+    struct ArenaChunk *next;
+} ArenaChunk;
+
+// Freed blocks are threaded through their own first word
+typedef struct FreeBlock
+{
+    struct FreeBlock *next;
+} FreeBlock;
+
+struct Arena
+{
+    ArenaOptions opts;
+    ArenaChunk *chunks;
+    char *cursor; // Next free byte in the newest chunk
+    char *limit;  // End of the newest chunk
+    FreeBlock *free_lists[ARENA_NUM_CLASSES];
+    size_t bytes_in_use;
+    size_t bytes_free_listed;
+    int owners; // arena_destroy calls still needed before the chunks are unmapped
+};
+
+// --- Helper Functions ---
+
+static size_t round_up(size_t n, size_t multiple)
+{
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+#ifdef ARENA_HAVE_MMAP
+// Binds [addr, addr+len) to a single NUMA node before any page is touched
+static int bind_numa_node(void *addr, size_t len, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long mask[4] = {0};
+    if (node < 0 || node >= (int)(sizeof(mask) * 8))
+        return 0;
+    mask[node / (sizeof(unsigned long) * 8)] |= 1UL << (node % (sizeof(unsigned long) * 8));
+    return syscall(SYS_mbind, addr, len, MPOL_BIND_MODE, mask, sizeof(mask) * 8, 0) == 0;
+#else
+    (void)addr;
+    (void)len;
+    (void)node;
+    return 0;
+#endif
+}
+
+// Maps a chunk aligned to ARENA_HUGE_PAGE_SIZE so THP can back it with 2MB pages
+static void *map_aligned(size_t size)
+{
+    size_t span = size + ARENA_HUGE_PAGE_SIZE;
+    char *raw = (char *)mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return NULL;
+
+    char *aligned = (char *)round_up((size_t)raw, ARENA_HUGE_PAGE_SIZE);
+    // Trim the unaligned head and the leftover tail
+    if (aligned > raw)
+        munmap(raw, (size_t)(aligned - raw));
+    size_t tail = (size_t)(raw + span - (aligned + size));
+    if (tail > 0)
+        munmap(aligned + size, tail);
+    return aligned;
+}
+#endif
+
+// Obtains a new chunk from the kernel according to the arena's page mode
+static ArenaChunk *map_chunk(Arena *arena, size_t size)
+{
+    ArenaChunk *chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk));
+    if (!chunk)
+        return NULL;
+    chunk->base = NULL;
+    chunk->size = size;
+    chunk->kind = CHUNK_MALLOC;
+    chunk->numa_bound = 0;
+
+#ifdef ARENA_HAVE_MMAP
+#ifdef MAP_HUGETLB
+    if (arena->opts.page_mode == ARENA_PAGES_EXPLICIT)
+    {
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            chunk->base = (char *)p;
+            chunk->kind = CHUNK_EXPLICIT;
+        }
+        // An empty hugetlbfs pool is common; fall through to transparent pages
+    }
+#endif
+    if (!chunk->base && arena->opts.page_mode != ARENA_PAGES_DEFAULT)
+    {
+        chunk->base = (char *)map_aligned(size);
+        if (chunk->base)
+        {
+            chunk->kind = CHUNK_TRANSPARENT;
+#ifdef MADV_HUGEPAGE
+            madvise(chunk->base, size, MADV_HUGEPAGE);
+#endif
+        }
+    }
+    if (!chunk->base)
+    {
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            chunk->base = (char *)p;
+            chunk->kind = CHUNK_MMAP;
+        }
+    }
+    if (chunk->base && arena->opts.numa_node >= 0)
+    {
+        chunk->numa_bound = bind_numa_node(chunk->base, size, arena->opts.numa_node);
+        if (!chunk->numa_bound && !arena->chunks)
+        {
+            perror("Warning: could not bind arena to NUMA node");
+        }
+    }
+#else
+    (void)arena;
+#endif
+
+    if (!chunk->base)
+    {
+        chunk->base = (char *)malloc(size);
+        chunk->kind = CHUNK_MALLOC;
+    }
+    if (!chunk->base)
+    {
+        free(chunk);
+        return NULL;
+    }
+    return chunk;
+}
+
+static void unmap_chunk(ArenaChunk *chunk)
+{
+#ifdef ARENA_HAVE_MMAP
+    if (chunk->kind != CHUNK_MALLOC)
+    {
+        munmap(chunk->base, chunk->size);
+        return;
+    }
+#endif
+    free(chunk->base);
+}
+
+#ifdef __linux__
+// Sums AnonHugePages of every mapping in /proc/self/smaps that overlaps a chunk
+static size_t read_huge_resident(Arena *arena)
+{
+    FILE *fp = fopen("/proc/self/smaps", "r");
+    if (!fp)
+        return 0;
+
+    char line[256];
+    int overlaps = 0;
+    size_t total_kb = 0;
+    while (fgets(line, sizeof(line), fp))
+    {
+        unsigned long start, end, kb;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+        {
+            overlaps = 0;
+            for (ArenaChunk *c = arena->chunks; c; c = c->next)
+            {
+                unsigned long cs = (unsigned long)c->base;
+                if (cs < end && cs + c->size > start)
+                {
+                    overlaps = 1;
+                    break;
+                }
+            }
+        }
+        else if (overlaps && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1)
+        {
+            total_kb += kb;
+        }
+    }
+    fclose(fp);
+    return total_kb * 1024;
+}
+#endif
+
+// --- Public API ---
+
+void arena_default_options(ArenaOptions *opts)
+{
+    opts->page_mode = ARENA_PAGES_TRANSPARENT;
+    opts->numa_node = -1;
+    opts->chunk_size = ARENA_DEFAULT_CHUNK_SIZE;
+}
+
+Arena *arena_create(const ArenaOptions *opts)
+{
+    Arena *arena = (Arena *)calloc(1, sizeof(Arena));
+    if (!arena)
+        return NULL;
+
+    arena->owners = 1;
+    if (opts)
+        arena->opts = *opts;
+    else
+        arena_default_options(&arena->opts);
+
+    if (arena->opts.chunk_size == 0)
+        arena->opts.chunk_size = ARENA_DEFAULT_CHUNK_SIZE;
+    arena->opts.chunk_size = round_up(arena->opts.chunk_size, ARENA_HUGE_PAGE_SIZE);
+    return arena;
+}
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+    if (!arena || size > ARENA_MAX_BLOCK)
+        return malloc(size);
+
+    size_t rounded = round_up(size ? size : 1, ARENA_ALIGN);
+    size_t cls = rounded / ARENA_ALIGN;
+
+    // Reuse a freed block of the same class first
+    FreeBlock *block = arena->free_lists[cls];
+    if (block)
+    {
+        arena->free_lists[cls] = block->next;
+        arena->bytes_free_listed -= rounded;
+        arena->bytes_in_use += rounded;
+        return block;
+    }
+
+    if (!arena->cursor || (size_t)(arena->limit - arena->cursor) < rounded)
+    {
+        // The unused tail of the old chunk is abandoned; it is at most ARENA_MAX_BLOCK bytes
+        ArenaChunk *chunk = map_chunk(arena, arena->opts.chunk_size);
+        if (!chunk)
+            return NULL;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->cursor = chunk->base;
+        arena->limit = chunk->base + chunk->size;
+    }
+
+    void *p = arena->cursor;
+    arena->cursor += rounded;
+    arena->bytes_in_use += rounded;
+    return p;
+}
+
+void arena_free(Arena *arena, void *ptr, size_t size)
+{
+    if (!ptr)
+        return;
+    if (!arena || size > ARENA_MAX_BLOCK)
+    {
+        free(ptr);
+        return;
+    }
+
+    size_t rounded = round_up(size ? size : 1, ARENA_ALIGN);
+    FreeBlock *block = (FreeBlock *)ptr;
+    block->next = arena->free_lists[rounded / ARENA_ALIGN];
+    arena->free_lists[rounded / ARENA_ALIGN] = block;
+    arena->bytes_in_use -= rounded;
+    arena->bytes_free_listed += rounded;
+}
+
+Arena *arena_retain(Arena *arena)
+{
+    if (arena)
+        arena->owners++;
+    return arena;
+}
+
+int arena_shared(const Arena *arena)
+{
+    return arena && arena->owners > 1;
+}
+
+void arena_destroy(Arena *arena)
+{
+    if (!arena || --arena->owners > 0)
+        return;
+    ArenaChunk *chunk = arena->chunks;
+    while (chunk)
+    {
+        ArenaChunk *next = chunk->next;
+        unmap_chunk(chunk);
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+void arena_get_stats(Arena *arena, ArenaStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (!arena)
+        return;
+
+    for (ArenaChunk *c = arena->chunks; c; c = c->next)
+    {
+        stats->chunks++;
+        stats->bytes_mapped += c->size;
+        if (c->kind == CHUNK_EXPLICIT)
+            stats->explicit_chunks++;
+        else if (c->kind == CHUNK_TRANSPARENT)
+            stats->transparent_chunks++;
+        if (c->numa_bound)
+            stats->numa_bound_chunks++;
+        if (c->kind == CHUNK_EXPLICIT)
+            stats->huge_resident += c->size;
+    }
+    stats->bytes_in_use = arena->bytes_in_use;
+    stats->bytes_free_listed = arena->bytes_free_listed;
+
+#ifdef __linux__
+    if (stats->transparent_chunks > 0)
+        stats->huge_resident += read_huge_resident(arena);
+#endif
+    if (stats->huge_resident > stats->bytes_mapped)
+        stats->huge_resident = stats->bytes_mapped;
+
+    stats->tlb_entries = stats->huge_resident / ARENA_HUGE_PAGE_SIZE +
+                         round_up(stats->bytes_mapped - stats->huge_resident, ARENA_SMALL_PAGE_SIZE) / ARENA_SMALL_PAGE_SIZE;
+    stats->tlb_entries_4k = round_up(stats->bytes_mapped, ARENA_SMALL_PAGE_SIZE) / ARENA_SMALL_PAGE_SIZE;
+}
+
+void print_arena_stats(Arena *arena)
+{
+    ArenaStats s;
+    arena_get_stats(arena, &s);
+    printf("  Arena Chunks: %lu (%lu explicit huge, %lu transparent huge, %lu NUMA-bound)\n",
+           (unsigned long)s.chunks, (unsigned long)s.explicit_chunks,
+           (unsigned long)s.transparent_chunks, (unsigned long)s.numa_bound_chunks);
+    printf("  Arena Bytes: %lu mapped, %lu in use, %lu on free lists\n",
+           (unsigned long)s.bytes_mapped, (unsigned long)s.bytes_in_use, (unsigned long)s.bytes_free_listed);
+    printf("  Huge-Page Backed: %lu bytes\n", (unsigned long)s.huge_resident);
+    printf("  TLB Entries to Cover Arena: %lu (vs %lu with 4K pages)\n",
+           (unsigned long)s.tlb_entries, (unsigned long)s.tlb_entries_4k);
+}
@@ -0,0 +1,58 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h> // size_t
+
+// --- Tunable Parameters ---
+// Size of a huge page on x86-64/aarch64 Linux. Chunks are sized and aligned to this.
+#define ARENA_HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+// Default bytes reserved per chunk (a multiple of ARENA_HUGE_PAGE_SIZE)
+#define ARENA_DEFAULT_CHUNK_SIZE (32UL * 1024 * 1024)
+// Allocation granularity; every block handed out is aligned to this
+#define ARENA_ALIGN 16
+// Largest block served from the size-class free lists. Bigger requests go to malloc.
+#define ARENA_MAX_BLOCK 1024
+// -------------------------
+
+// How chunks are backed by the kernel
+typedef enum
+{
+    ARENA_PAGES_DEFAULT = 0, // Regular pages (4K on most systems)
+    ARENA_PAGES_TRANSPARENT, // 2MB-aligned chunks advised with MADV_HUGEPAGE
+    ARENA_PAGES_EXPLICIT     // MAP_HUGETLB from the hugetlbfs pool, falls back to transparent
+} ArenaPageMode;
+
+typedef struct
+{
+    ArenaPageMode page_mode;
+    int numa_node;     // NUMA node to bind chunks to (-1 = no binding)
+    size_t chunk_size; // Bytes per chunk (0 = ARENA_DEFAULT_CHUNK_SIZE)
+} ArenaOptions;
+
+typedef struct
+{
+    size_t chunks;             // Chunks mapped so far
+    size_t explicit_chunks;    // Chunks backed by MAP_HUGETLB pages
+    size_t transparent_chunks; // Chunks advised for transparent huge pages
+    size_t numa_bound_chunks;  // Chunks successfully bound to opts.numa_node
+    size_t bytes_mapped;       // Total bytes reserved from the kernel
+    size_t bytes_in_use;       // Bytes handed out and not yet freed
+    size_t bytes_free_listed;  // Bytes sitting in the free lists, ready for reuse
+    size_t huge_resident;      // Bytes actually backed by huge pages (from /proc/self/smaps)
+    size_t tlb_entries;        // Page translations needed to cover the arena with its real backing
+    size_t tlb_entries_4k;     // Page translations the same bytes would need with 4K pages only
+} ArenaStats;
+
+typedef struct Arena Arena;
+
+void arena_default_options(ArenaOptions *opts);
+Arena *arena_create(const ArenaOptions *opts); // Returns NULL on allocation failure
+void *arena_alloc(Arena *arena, size_t size);  // NULL arena means plain malloc
+void arena_free(Arena *arena, void *ptr, size_t size); // size must match the arena_alloc call
+void arena_destroy(Arena *arena);              // Releases every chunk at once (once the last owner lets go)
+Arena *arena_retain(Arena *arena);             // Adds an owner (lists split from one list share its arena)
+int arena_shared(const Arena *arena);          // True while more than one owner holds the arena
+void arena_get_stats(Arena *arena, ArenaStats *stats);
+void print_arena_stats(Arena *arena);
+
+#endif // ARENA_H
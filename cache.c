@@ -0,0 +1,134 @@
+#include "cache.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// Maps a key to its set. Multiplicative hashing spreads sequential IDs.
+static CacheSet *set_for(KeyCache *cache, int key)
+{
+    uint32_t h = (uint32_t)key * 2654435761u;
+    h ^= h >> 16;
+    return &cache->sets[h & cache->mask];
+}
+
+KeyCache *cache_create(size_t entries)
+{
+    KeyCache *cache = (KeyCache *)calloc(1, sizeof(KeyCache));
+    if (!cache)
+        return NULL;
+
+    size_t sets = 1;
+    while (sets * CACHE_WAYS < entries)
+    {
+        sets <<= 1;
+    }
+
+    // Over-allocate so the sets can start on a cache-line boundary
+    cache->raw = malloc(sets * sizeof(CacheSet) + CACHE_LINE_SIZE - 1);
+    if (!cache->raw)
+    {
+        free(cache);
+        return NULL;
+    }
+    cache->sets = (CacheSet *)(((uintptr_t)cache->raw + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+    cache->mask = sets - 1;
+    cache_clear(cache);
+    return cache;
+}
+
+Record *cache_lookup(KeyCache *cache, int key)
+{
+    CacheSet *set = set_for(cache, key);
+    for (int w = 0; w < CACHE_WAYS; w++)
+    {
+        if (set->keys[w] == key)
+        {
+            set->ref[w] = 1;
+            cache->hits++;
+            return set->values[w];
+        }
+    }
+    cache->misses++;
+    return NULL;
+}
+
+void cache_insert(KeyCache *cache, int key, Record *value)
+{
+    CacheSet *set = set_for(cache, key);
+
+    // Refresh an existing entry or take an empty way
+    for (int w = 0; w < CACHE_WAYS; w++)
+    {
+        if (set->keys[w] == key || set->keys[w] == -1)
+        {
+            set->keys[w] = key;
+            set->values[w] = value;
+            set->ref[w] = 1;
+            return;
+        }
+    }
+
+    // CLOCK: skip (and clear) recently referenced ways
+    while (set->ref[set->hand])
+    {
+        set->ref[set->hand] = 0;
+        set->hand = (unsigned char)((set->hand + 1) % CACHE_WAYS);
+    }
+    set->keys[set->hand] = key;
+    set->values[set->hand] = value;
+    set->ref[set->hand] = 1;
+    set->hand = (unsigned char)((set->hand + 1) % CACHE_WAYS);
+}
+
+void cache_invalidate(KeyCache *cache, int key)
+{
+    CacheSet *set = set_for(cache, key);
+    for (int w = 0; w < CACHE_WAYS; w++)
+    {
+        if (set->keys[w] == key)
+        {
+            set->keys[w] = -1;
+            set->values[w] = NULL;
+            set->ref[w] = 0;
+            cache->invalidations++;
+            return;
+        }
+    }
+}
+
+void cache_clear(KeyCache *cache)
+{
+    for (size_t s = 0; s <= cache->mask; s++)
+    {
+        for (int w = 0; w < CACHE_WAYS; w++)
+        {
+            cache->sets[s].keys[w] = -1;
+            cache->sets[s].values[w] = NULL;
+            cache->sets[s].ref[w] = 0;
+        }
+        cache->sets[s].hand = 0;
+    }
+}
+
+void cache_destroy(KeyCache *cache)
+{
+    if (!cache)
+        return;
+    free(cache->raw);
+    free(cache);
+}
+
+size_t cache_capacity(const KeyCache *cache)
+{
+    return (cache->mask + 1) * CACHE_WAYS;
+}
+
+size_t cache_bytes(const KeyCache *cache)
+{
+    return sizeof(KeyCache) + (cache->mask + 1) * sizeof(CacheSet) + CACHE_LINE_SIZE - 1;
+}
+
+double cache_hit_rate(const KeyCache *cache)
+{
+    size_t lookups = cache->hits + cache->misses;
+    return lookups ? (double)cache->hits / (double)lookups : 0.0;
+}
@@ -0,0 +1,44 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "record.h"
+#include <stddef.h> // size_t
+
+// --- Tunable Parameters ---
+// Entries per set. One set fills exactly one 64-byte cache line.
+#define CACHE_WAYS 4
+#define CACHE_LINE_SIZE 64
+// -------------------------
+
+// One cache line: CACHE_WAYS keys and their records, replaced with CLOCK
+typedef struct
+{
+    Record *values[CACHE_WAYS];    // Cached record for each way
+    int keys[CACHE_WAYS];          // Key held by each way (-1 = empty)
+    unsigned char ref[CACHE_WAYS]; // CLOCK reference bits
+    unsigned char hand;            // Next way to consider for eviction
+    char pad[CACHE_LINE_SIZE - CACHE_WAYS * (sizeof(Record *) + sizeof(int) + 1) - 1];
+} CacheSet;
+
+// Set-associative lookaside cache mapping recently read keys to their records
+typedef struct
+{
+    CacheSet *sets;       // Cache-line aligned array of sets
+    void *raw;            // Allocation backing sets (before alignment)
+    size_t mask;          // Number of sets - 1 (power of two)
+    size_t hits;          // Lookups served from the cache
+    size_t misses;        // Lookups that fell through to the skip list
+    size_t invalidations; // Entries dropped because their key was deleted
+} KeyCache;
+
+KeyCache *cache_create(size_t entries); // entries is rounded up to a power-of-two number of sets
+Record *cache_lookup(KeyCache *cache, int key);
+void cache_insert(KeyCache *cache, int key, Record *value);
+void cache_invalidate(KeyCache *cache, int key);
+void cache_clear(KeyCache *cache);
+void cache_destroy(KeyCache *cache);
+size_t cache_capacity(const KeyCache *cache);
+size_t cache_bytes(const KeyCache *cache);
+double cache_hit_rate(const KeyCache *cache);
+
+#endif // CACHE_H
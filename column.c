@@ -0,0 +1,387 @@
+#include "column.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// --- Helper Functions ---
+
+// Index of the block that should hold id: the last block whose first id is <= id
+static size_t find_block(const ValueColumn *column, int id)
+{
+    size_t lo = 0, hi = column->num_blocks;
+    while (hi - lo > 1)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (column->blocks[mid]->ids[0] <= id)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// First position in a block whose id is >= id
+static size_t lower_bound(const ColumnBlock *block, int id)
+{
+    size_t lo = 0, hi = block->count;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (block->ids[mid] < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// First position in a block whose id is > id
+static size_t upper_bound(const ColumnBlock *block, int id)
+{
+    size_t lo = 0, hi = block->count;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (block->ids[mid] <= id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Inserts an empty block into the directory at position pos
+static ColumnBlock *insert_block(ValueColumn *column, size_t pos)
+{
+    if (column->num_blocks == column->cap_blocks)
+    {
+        size_t cap = column->cap_blocks ? column->cap_blocks * 2 : 16;
+        ColumnBlock **blocks = (ColumnBlock **)realloc(column->blocks, cap * sizeof(ColumnBlock *));
+        if (!blocks)
+            return NULL;
+        column->blocks = blocks;
+        column->cap_blocks = cap;
+    }
+
+    ColumnBlock *block = (ColumnBlock *)malloc(sizeof(ColumnBlock));
+    if (!block)
+        return NULL;
+    block->count = 0;
+
+    memmove(&column->blocks[pos + 1], &column->blocks[pos], (column->num_blocks - pos) * sizeof(ColumnBlock *));
+    column->blocks[pos] = block;
+    column->num_blocks++;
+    return block;
+}
+
+static void remove_block(ValueColumn *column, size_t pos)
+{
+    free(column->blocks[pos]);
+    memmove(&column->blocks[pos], &column->blocks[pos + 1], (column->num_blocks - pos - 1) * sizeof(ColumnBlock *));
+    column->num_blocks--;
+}
+
+// --- Public API ---
+
+ValueColumn *column_create()
+{
+    return (ValueColumn *)calloc(1, sizeof(ValueColumn));
+}
+
+int column_insert(ValueColumn *column, int id, double value)
+{
+    if (column->num_blocks == 0 && !insert_block(column, 0))
+        return 0;
+
+    size_t b = find_block(column, id);
+    ColumnBlock *block = column->blocks[b];
+    size_t pos = lower_bound(block, id);
+
+    if (block->count == COLUMN_BLOCK_SIZE)
+    {
+        ColumnBlock *next = insert_block(column, b + 1);
+        if (!next)
+            return 0;
+        block = column->blocks[b];
+
+        if (pos == COLUMN_BLOCK_SIZE && b + 2 == column->num_blocks)
+        {
+            // Appending past the end: start a fresh block so sequential ingestion keeps blocks full
+            block = next;
+            pos = 0;
+        }
+        else
+        {
+            // Split the full block in half and insert into whichever half covers id
+            size_t half = COLUMN_BLOCK_SIZE / 2;
+            memcpy(next->ids, block->ids + half, half * sizeof(int));
+            memcpy(next->values, block->values + half, half * sizeof(double));
+            next->count = half;
+            block->count = half;
+            if (pos > half)
+            {
+                block = next;
+                pos -= half;
+            }
+        }
+    }
+
+    memmove(block->ids + pos + 1, block->ids + pos, (block->count - pos) * sizeof(int));
+    memmove(block->values + pos + 1, block->values + pos, (block->count - pos) * sizeof(double));
+    block->ids[pos] = id;
+    block->values[pos] = value;
+    block->count++;
+    column->count++;
+    return 1;
+}
+
+int column_remove(ValueColumn *column, int id)
+{
+    if (column->num_blocks == 0)
+        return 0;
+
+    size_t b = find_block(column, id);
+    ColumnBlock *block = column->blocks[b];
+    size_t pos = lower_bound(block, id);
+    if (pos == block->count || block->ids[pos] != id)
+        return 0;
+
+    memmove(block->ids + pos, block->ids + pos + 1, (block->count - pos - 1) * sizeof(int));
+    memmove(block->values + pos, block->values + pos + 1, (block->count - pos - 1) * sizeof(double));
+    block->count--;
+    column->count--;
+
+    if (block->count == 0)
+    {
+        remove_block(column, b);
+    }
+    else if (block->count < COLUMN_BLOCK_SIZE / 4 && b + 1 < column->num_blocks &&
+             block->count + column->blocks[b + 1]->count <= COLUMN_BLOCK_SIZE / 2)
+    {
+        // Fold a sparse block into its neighbour so scans stay dense
+        ColumnBlock *next = column->blocks[b + 1];
+        memcpy(block->ids + block->count, next->ids, next->count * sizeof(int));
+        memcpy(block->values + block->count, next->values, next->count * sizeof(double));
+        block->count += next->count;
+        remove_block(column, b + 1);
+    }
+    return 1;
+}
+
+int column_set(ValueColumn *column, int id, double value)
+{
+    if (column->num_blocks == 0)
+        return 0;
+
+    ColumnBlock *block = column->blocks[find_block(column, id)];
+    size_t pos = lower_bound(block, id);
+    if (pos == block->count || block->ids[pos] != id)
+        return 0;
+    block->values[pos] = value;
+    return 1;
+}
+
+void column_aggregate(const ValueColumn *column, int lo, int hi, Aggregate *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (column->num_blocks == 0 || lo > hi)
+        return;
+
+    size_t b = find_block(column, lo);
+    size_t start = lower_bound(column->blocks[b], lo);
+    for (; b < column->num_blocks; b++, start = 0)
+    {
+        const ColumnBlock *block = column->blocks[b];
+        if (block->ids[0] > hi)
+            break;
+
+        // Whole tail of the block is in range unless the block crosses hi
+        size_t end = block->count;
+        if (block->ids[block->count - 1] > hi)
+            end = upper_bound(block, hi);
+        if (end > start)
+            aggregate_values(block->values + start, end - start, out);
+    }
+}
+
+ValueColumn *column_split(ValueColumn *column, int id)
+{
+    ValueColumn *upper = column_create();
+    if (!upper || column->num_blocks == 0)
+        return upper;
+
+    size_t b = find_block(column, id);
+    ColumnBlock *block = column->blocks[b];
+    size_t pos = lower_bound(block, id);
+    if (pos == block->count)
+    {
+        b++; // The cut falls between blocks
+        pos = 0;
+    }
+
+    // Room for the tail of a block that has to be cut, plus every later block
+    size_t moved = column->num_blocks - b;
+    upper->cap_blocks = moved > 0 ? moved : 1;
+    upper->blocks = (ColumnBlock **)malloc(upper->cap_blocks * sizeof(ColumnBlock *));
+    if (!upper->blocks)
+    {
+        free(upper);
+        return NULL;
+    }
+    if (pos > 0)
+    {
+        // Copy the upper part of the cut block into a block of its own
+        ColumnBlock *tail = insert_block(upper, 0);
+        if (!tail)
+        {
+            column_destroy(upper);
+            return NULL;
+        }
+        block = column->blocks[b];
+        tail->count = block->count - pos;
+        memcpy(tail->ids, block->ids + pos, tail->count * sizeof(int));
+        memcpy(tail->values, block->values + pos, tail->count * sizeof(double));
+        block->count = pos;
+        column->count -= tail->count;
+        upper->count += tail->count;
+        b++;
+    }
+    for (size_t i = b; i < column->num_blocks; i++)
+    {
+        upper->blocks[upper->num_blocks++] = column->blocks[i];
+        column->count -= column->blocks[i]->count;
+        upper->count += column->blocks[i]->count;
+    }
+    column->num_blocks = b;
+    return upper;
+}
+
+int column_concat(ValueColumn *dst, ValueColumn *src)
+{
+    if (src->num_blocks == 0)
+        return 1; // src->blocks may still be NULL
+    size_t needed = dst->num_blocks + src->num_blocks;
+    if (needed > dst->cap_blocks)
+    {
+        ColumnBlock **blocks = (ColumnBlock **)realloc(dst->blocks, needed * sizeof(ColumnBlock *));
+        if (!blocks)
+            return 0;
+        dst->blocks = blocks;
+        dst->cap_blocks = needed;
+    }
+    memcpy(dst->blocks + dst->num_blocks, src->blocks, src->num_blocks * sizeof(ColumnBlock *));
+    dst->num_blocks = needed;
+    dst->count += src->count;
+    src->num_blocks = 0;
+    src->count = 0;
+    return 1;
+}
+
+size_t column_bytes(const ValueColumn *column)
+{
+    return sizeof(ValueColumn) + column->cap_blocks * sizeof(ColumnBlock *) +
+           column->num_blocks * sizeof(ColumnBlock);
+}
+
+void column_destroy(ValueColumn *column)
+{
+    if (!column)
+        return;
+    for (size_t b = 0; b < column->num_blocks; b++)
+    {
+        free(column->blocks[b]);
+    }
+    free(column->blocks);
+    free(column);
+}
+
+// --- Reduction Kernel ---
+
+void aggregate_values(const double *values, size_t n, Aggregate *out)
+{
+    if (n == 0)
+        return;
+
+    size_t i = 0;
+    double sum = 0.0;
+    double min = values[0];
+    double max = values[0];
+
+#if defined(__AVX__)
+    // 4 doubles per register, two independent accumulators to hide add latency
+    if (n >= 8)
+    {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256d mn = _mm256_loadu_pd(values), mx = mn;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256d a = _mm256_loadu_pd(values + i);
+            __m256d b = _mm256_loadu_pd(values + i + 4);
+            s0 = _mm256_add_pd(s0, a);
+            s1 = _mm256_add_pd(s1, b);
+            mn = _mm256_min_pd(mn, _mm256_min_pd(a, b));
+            mx = _mm256_max_pd(mx, _mm256_max_pd(a, b));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(s0, s1));
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm256_storeu_pd(lanes, mn);
+        for (int k = 0; k < 4; k++)
+            min = lanes[k] < min ? lanes[k] : min;
+        _mm256_storeu_pd(lanes, mx);
+        for (int k = 0; k < 4; k++)
+            max = lanes[k] > max ? lanes[k] : max;
+    }
+#elif defined(__SSE2__)
+    // 2 doubles per register, four independent accumulators to hide add latency
+    if (n >= 8)
+    {
+        __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), s2 = _mm_setzero_pd(), s3 = _mm_setzero_pd();
+        __m128d mn = _mm_loadu_pd(values), mx = mn;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128d a = _mm_loadu_pd(values + i);
+            __m128d b = _mm_loadu_pd(values + i + 2);
+            __m128d c = _mm_loadu_pd(values + i + 4);
+            __m128d d = _mm_loadu_pd(values + i + 6);
+            s0 = _mm_add_pd(s0, a);
+            s1 = _mm_add_pd(s1, b);
+            s2 = _mm_add_pd(s2, c);
+            s3 = _mm_add_pd(s3, d);
+            mn = _mm_min_pd(mn, _mm_min_pd(_mm_min_pd(a, b), _mm_min_pd(c, d)));
+            mx = _mm_max_pd(mx, _mm_max_pd(_mm_max_pd(a, b), _mm_max_pd(c, d)));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+        sum = lanes[0] + lanes[1];
+        _mm_storeu_pd(lanes, mn);
+        min = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+        _mm_storeu_pd(lanes, mx);
+        max = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    }
+#endif
+
+    // Scalar tail (and the whole range on targets without SIMD)
+    for (; i < n; i++)
+    {
+        sum += values[i];
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+    }
+
+    if (out->count == 0)
+    {
+        out->min = min;
+        out->max = max;
+    }
+    else
+    {
+        out->min = min < out->min ? min : out->min;
+        out->max = max > out->max ? max : out->max;
+    }
+    out->sum += sum;
+    out->count += n;
+}
@@ -0,0 +1,55 @@
+#ifndef COLUMN_H
+#define COLUMN_H
+
+#include <stddef.h> // size_t
+
+// --- Tunable Parameters ---
+// Records per block. Each block keeps IDs and values in contiguous arrays.
+#define COLUMN_BLOCK_SIZE 1024
+// -------------------------
+
+// Result of an aggregate query over an ID range
+typedef struct
+{
+    size_t count; // Records in the range
+    double sum;
+    double min; // Only meaningful when count > 0
+    double max; // Only meaningful when count > 0
+} Aggregate;
+
+// A sorted run of (id, value) pairs
+typedef struct
+{
+    size_t count;
+    int ids[COLUMN_BLOCK_SIZE];
+    double values[COLUMN_BLOCK_SIZE];
+} ColumnBlock;
+
+// Columnar side copy of Record.value, ordered by ID like the skip list.
+// Aggregates scan the contiguous value arrays instead of chasing node pointers.
+typedef struct
+{
+    ColumnBlock **blocks; // Blocks in key order
+    size_t num_blocks;
+    size_t cap_blocks;
+    size_t count; // Total (id, value) pairs
+} ValueColumn;
+
+ValueColumn *column_create();
+int column_insert(ValueColumn *column, int id, double value); // Returns 0 on allocation failure
+int column_remove(ValueColumn *column, int id);               // Returns 1 if the id was present
+int column_set(ValueColumn *column, int id, double value);    // Returns 1 if the id was present
+void column_aggregate(const ValueColumn *column, int lo, int hi, Aggregate *out);
+// Moves every pair with an id >= id into a new column (whole blocks move by pointer).
+// NULL on allocation failure, with column unchanged.
+ValueColumn *column_split(ValueColumn *column, int id);
+// Appends src's blocks to dst, leaving src empty. Every id in src must be greater
+// than every id in dst. Returns 0 on allocation failure, with both unchanged.
+int column_concat(ValueColumn *dst, ValueColumn *src);
+size_t column_bytes(const ValueColumn *column);
+void column_destroy(ValueColumn *column);
+
+// Adds values[0..n) into an aggregate using the widest SIMD the build targets
+void aggregate_values(const double *values, size_t n, Aggregate *out);
+
+#endif // COLUMN_H
@@ -0,0 +1,187 @@
+#include "cuckoo.h"
+#include <stdlib.h>
+
+// --- Helper Functions ---
+
+// 64-bit finalizer (splitmix64) so nearby IDs land in unrelated buckets
+static uint64_t mix64(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Fingerprint in 1..255 (0 marks an empty slot)
+static uint8_t fingerprint_of(uint64_t h)
+{
+    return (uint8_t)((h >> 32) % 255 + 1);
+}
+
+// Partial-key cuckoo hashing: the alternate bucket depends only on the
+// current bucket and the fingerprint, so entries can move without the key.
+static size_t alt_bucket(const CuckooFilter *filter, size_t bucket, uint8_t fp)
+{
+    return (bucket ^ (size_t)(fp * 0x5bd1e995u)) & filter->mask;
+}
+
+static int bucket_add(CuckooFilter *filter, size_t bucket, uint8_t fp)
+{
+    for (int s = 0; s < CUCKOO_SLOTS; s++)
+    {
+        if (filter->buckets[bucket][s] == 0)
+        {
+            filter->buckets[bucket][s] = fp;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int bucket_has(const CuckooFilter *filter, size_t bucket, uint8_t fp)
+{
+    for (int s = 0; s < CUCKOO_SLOTS; s++)
+    {
+        if (filter->buckets[bucket][s] == fp)
+            return 1;
+    }
+    return 0;
+}
+
+static int bucket_remove(CuckooFilter *filter, size_t bucket, uint8_t fp)
+{
+    for (int s = 0; s < CUCKOO_SLOTS; s++)
+    {
+        if (filter->buckets[bucket][s] == fp)
+        {
+            filter->buckets[bucket][s] = 0;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Eviction walks draw from the filter's own generator instead of the shared rand()
+static uint32_t next_random(CuckooFilter *filter)
+{
+    uint32_t x = filter->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return filter->rng = x;
+}
+
+// --- Public API ---
+
+CuckooFilter *cuckoo_create(size_t expected_keys)
+{
+    CuckooFilter *filter = (CuckooFilter *)calloc(1, sizeof(CuckooFilter));
+    if (!filter)
+        return NULL;
+
+    size_t buckets = 1;
+    while ((double)(buckets * CUCKOO_SLOTS) * CUCKOO_MAX_LOAD < (double)expected_keys)
+    {
+        buckets <<= 1;
+    }
+
+    filter->buckets = calloc(buckets, sizeof(*filter->buckets));
+    if (!filter->buckets)
+    {
+        free(filter);
+        return NULL;
+    }
+    filter->mask = buckets - 1;
+    filter->rng = 0x9E3779B9u; // Fixed: evictions only need to vary, not to be unpredictable
+    return filter;
+}
+
+int cuckoo_insert(CuckooFilter *filter, int key)
+{
+    uint64_t h = mix64((uint64_t)(unsigned int)key);
+    uint8_t fp = fingerprint_of(h);
+    size_t i1 = (size_t)h & filter->mask;
+    size_t i2 = alt_bucket(filter, i1, fp);
+
+    if (bucket_add(filter, i1, fp) || bucket_add(filter, i2, fp))
+    {
+        filter->count++;
+        return 1;
+    }
+
+    // Both buckets full: evict fingerprints along a random walk
+    size_t bucket = (next_random(filter) & 1) ? i1 : i2;
+    for (int kick = 0; kick < CUCKOO_MAX_KICKS; kick++)
+    {
+        int slot = (int)(next_random(filter) % CUCKOO_SLOTS);
+        uint8_t victim = filter->buckets[bucket][slot];
+        filter->buckets[bucket][slot] = fp;
+        fp = victim;
+        bucket = alt_bucket(filter, bucket, fp);
+        if (bucket_add(filter, bucket, fp))
+        {
+            filter->count++;
+            return 1;
+        }
+    }
+    // The last victim has no home; the caller rebuilds a larger filter from the list
+    return 0;
+}
+
+int cuckoo_contains(const CuckooFilter *filter, int key)
+{
+    uint64_t h = mix64((uint64_t)(unsigned int)key);
+    uint8_t fp = fingerprint_of(h);
+    size_t i1 = (size_t)h & filter->mask;
+    return bucket_has(filter, i1, fp) || bucket_has(filter, alt_bucket(filter, i1, fp), fp);
+}
+
+int cuckoo_remove(CuckooFilter *filter, int key)
+{
+    uint64_t h = mix64((uint64_t)(unsigned int)key);
+    uint8_t fp = fingerprint_of(h);
+    size_t i1 = (size_t)h & filter->mask;
+    if (bucket_remove(filter, i1, fp) || bucket_remove(filter, alt_bucket(filter, i1, fp), fp))
+    {
+        filter->count--;
+        return 1;
+    }
+    return 0;
+}
+
+int cuckoo_needs_growth(const CuckooFilter *filter)
+{
+    return (double)filter->count >= (double)cuckoo_slots(filter) * CUCKOO_MAX_LOAD;
+}
+
+size_t cuckoo_slots(const CuckooFilter *filter)
+{
+    return (filter->mask + 1) * CUCKOO_SLOTS;
+}
+
+size_t cuckoo_bytes(const CuckooFilter *filter)
+{
+    return sizeof(CuckooFilter) + (filter->mask + 1) * sizeof(*filter->buckets);
+}
+
+double cuckoo_expected_fpr(const CuckooFilter *filter)
+{
+    // Each probe compares against up to 2 * CUCKOO_SLOTS occupied slots,
+    // each matching a random fingerprint with probability 1/255
+    double load = (double)filter->count / (double)cuckoo_slots(filter);
+    return 2.0 * CUCKOO_SLOTS * load / 255.0;
+}
+
+double cuckoo_observed_fpr(const CuckooFilter *filter)
+{
+    size_t absent = filter->negatives + filter->false_positives;
+    return absent ? (double)filter->false_positives / (double)absent : 0.0;
+}
+
+void cuckoo_destroy(CuckooFilter *filter)
+{
+    if (!filter)
+        return;
+    free(filter->buckets);
+    free(filter);
+}
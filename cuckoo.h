@@ -0,0 +1,39 @@
+#ifndef CUCKOO_H
+#define CUCKOO_H
+
+#include <stddef.h> // size_t
+#include <stdint.h>
+
+// --- Tunable Parameters ---
+// Fingerprint slots per bucket (one bucket is a single 32-bit word)
+#define CUCKOO_SLOTS 4
+// Relocations tried before an insert gives up and the filter must grow
+#define CUCKOO_MAX_KICKS 500
+// Grow once this fraction of slots is occupied
+#define CUCKOO_MAX_LOAD 0.90
+// -------------------------
+
+// Cuckoo filter over record IDs. Unlike a Bloom filter it supports deletes,
+// so it can shadow the skip list exactly as records come and go.
+typedef struct
+{
+    uint8_t (*buckets)[CUCKOO_SLOTS]; // 8-bit fingerprints, 0 = empty slot
+    size_t mask;                      // Number of buckets - 1 (power of two)
+    size_t count;                     // Fingerprints stored
+    size_t negatives;                 // Probes answered "absent" by the filter alone
+    size_t false_positives;           // Probes that passed the filter but were not in the list
+    uint32_t rng;                     // xorshift state for eviction walks (never 0)
+} CuckooFilter;
+
+CuckooFilter *cuckoo_create(size_t expected_keys);
+int cuckoo_insert(CuckooFilter *filter, int key); // Returns 0 if the filter is too full (grow it)
+int cuckoo_contains(const CuckooFilter *filter, int key);
+int cuckoo_remove(CuckooFilter *filter, int key); // Returns 1 if a matching fingerprint was removed
+int cuckoo_needs_growth(const CuckooFilter *filter);
+size_t cuckoo_slots(const CuckooFilter *filter);
+size_t cuckoo_bytes(const CuckooFilter *filter);
+double cuckoo_expected_fpr(const CuckooFilter *filter); // Analytical rate at the current load
+double cuckoo_observed_fpr(const CuckooFilter *filter); // Measured over absent-key probes
+void cuckoo_destroy(CuckooFilter *filter);
+
+#endif // CUCKOO_H
@@ -0,0 +1,696 @@
+#include "iobackend.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IO_HAVE_POSIX 1
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IO_HAVE_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// How requests are actually issued for an open file
+enum
+{
+    IO_MODE_STDIO = 0, // FILE* with a large stdio buffer
+    IO_MODE_SYNC,      // pread/pwrite, one block at a time
+    IO_MODE_URING      // pread/pwrite equivalents queued on an io_uring
+};
+
+// Lifecycle of a staging buffer
+enum
+{
+    BUF_IDLE = 0, // Free to fill (write) / nothing requested (read)
+    BUF_BUSY,     // Request in flight
+    BUF_READY     // Read completed, data not yet fully consumed
+};
+
+typedef struct
+{
+    char *data;
+    size_t len;         // Bytes staged (write) or bytes valid (read)
+    size_t pos;         // Read cursor within data
+    long long offset;   // File offset of this block
+    int state;
+} IoBuffer;
+
+#ifdef IO_HAVE_URING
+// Minimal io_uring wrapper on the raw syscalls (no liburing dependency)
+typedef struct
+{
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_len, cq_len, sqes_len;
+} Ring;
+#endif
+
+struct IoFile
+{
+    int writing;
+    int mode;
+    FILE *fp;
+    int fd;
+    int direct;
+    int sync;
+    size_t block_size;
+    int depth;
+    char *raw;             // Allocation backing every buffer's data
+    IoBuffer *bufs;
+    int current;           // Buffer being filled (write) or consumed (read)
+    long long next_offset; // Next file offset to write or request
+    long long file_size;   // Read: size at open time. Write: logical bytes written.
+    int in_flight;
+    int error;
+#ifdef IO_HAVE_URING
+    Ring ring;
+    int ring_ready;
+#endif
+};
+
+// --- io_uring ---
+
+#ifdef IO_HAVE_URING
+static int ring_init(Ring *ring, unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0)
+        return 0; // Kernel too old, or io_uring disabled by policy
+
+    ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sq_ptr == MAP_FAILED || ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        if (ring->sq_ptr != MAP_FAILED)
+            munmap(ring->sq_ptr, ring->sq_len);
+        if (ring->cq_ptr != MAP_FAILED)
+            munmap(ring->cq_ptr, ring->cq_len);
+        if (ring->sqes != MAP_FAILED)
+            munmap(ring->sqes, ring->sqes_len);
+        close(ring->fd);
+        return 0;
+    }
+
+    char *sq = (char *)ring->sq_ptr;
+    char *cq = (char *)ring->cq_ptr;
+    ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 1;
+}
+
+static void ring_destroy(Ring *ring)
+{
+    munmap(ring->sqes, ring->sqes_len);
+    munmap(ring->cq_ptr, ring->cq_len);
+    munmap(ring->sq_ptr, ring->sq_len);
+    close(ring->fd);
+}
+
+// Queues one read or write and tells the kernel about it
+static int ring_submit(Ring *ring, int opcode, int fd, void *buf, size_t len, long long offset, int tag)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned idx = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (unsigned char)opcode;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long)(uintptr_t)buf;
+    sqe->len = (unsigned)len;
+    sqe->off = (unsigned long long)offset;
+    sqe->user_data = (unsigned long long)tag;
+    ring->sq_array[idx] = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    return syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0) == 1;
+}
+
+// Blocks until one completion is available and returns it
+static int ring_wait(Ring *ring, int *tag, int *res)
+{
+    while (1)
+    {
+        unsigned head = *ring->cq_head;
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+        {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            *tag = (int)cqe->user_data;
+            *res = cqe->res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+            return 1;
+        }
+        if (syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+            return 0;
+    }
+}
+#endif
+
+// --- Helper Functions ---
+
+#ifdef IO_HAVE_POSIX
+// pwrite/pread until done; both can legitimately transfer less than asked
+static int write_fully(int fd, const char *buf, size_t len, long long offset)
+{
+    while (len > 0)
+    {
+        ssize_t n = pwrite(fd, buf, len, (off_t)offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        buf += n;
+        len -= (size_t)n;
+        offset += n;
+    }
+    return 1;
+}
+
+static long long read_fully(int fd, char *buf, size_t len, long long offset)
+{
+    size_t total = 0;
+    while (total < len)
+    {
+        ssize_t n = pread(fd, buf + total, len - total, (off_t)(offset + (long long)total));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break; // EOF
+        total += (size_t)n;
+    }
+    return (long long)total;
+}
+#endif
+
+#ifdef IO_HAVE_POSIX
+// Performs the transfer for buffer b with pwrite/pread
+static void transfer_sync(IoFile *file, IoBuffer *b)
+{
+    if (file->writing)
+    {
+        if (!write_fully(file->fd, b->data, b->len, b->offset))
+            file->error = 1;
+        b->len = 0;
+        b->state = BUF_IDLE;
+    }
+    else
+    {
+        long long n = read_fully(file->fd, b->data, file->block_size, b->offset);
+        if (n < 0)
+        {
+            file->error = 1;
+            n = 0;
+        }
+        b->len = (size_t)n;
+        b->pos = 0;
+        b->state = BUF_READY;
+    }
+}
+#endif
+
+#ifdef IO_HAVE_URING
+// Applies the result of a finished request to its buffer
+static void complete_request(IoFile *file, int tag, int res)
+{
+    IoBuffer *b = &file->bufs[tag];
+    file->in_flight--;
+
+    if (res == -EINVAL || res == -EOPNOTSUPP)
+    {
+        // The ring exists but the kernel lacks IORING_OP_READ/WRITE (before 5.6):
+        // redo this request and everything after it synchronously
+        file->mode = IO_MODE_SYNC;
+        transfer_sync(file, b);
+        return;
+    }
+    if (res < 0)
+    {
+        errno = -res;
+        file->error = 1;
+        b->state = BUF_IDLE;
+        b->len = 0;
+        return;
+    }
+
+    // Short transfers are rare; finish them synchronously
+    size_t done = (size_t)res;
+    if (file->writing)
+    {
+        if (done < b->len && !write_fully(file->fd, b->data + done, b->len - done, b->offset + (long long)done))
+            file->error = 1;
+        b->len = 0;
+        b->state = BUF_IDLE;
+    }
+    else
+    {
+        long long want = file->file_size - b->offset;
+        if (want > (long long)file->block_size)
+            want = (long long)file->block_size;
+        if ((long long)done < want)
+        {
+            long long more = read_fully(file->fd, b->data + done, (size_t)(want - (long long)done), b->offset + (long long)done);
+            if (more < 0)
+                file->error = 1;
+            else
+                done += (size_t)more;
+        }
+        b->len = done;
+        b->pos = 0;
+        b->state = BUF_READY;
+    }
+}
+#endif
+
+// Waits for the oldest outstanding requests until buffer i is no longer busy
+static void wait_for_buffer(IoFile *file, int i)
+{
+#ifdef IO_HAVE_URING
+    while (file->bufs[i].state == BUF_BUSY)
+    {
+        int tag, res;
+        if (!ring_wait(&file->ring, &tag, &res))
+        {
+            file->error = 1;
+            file->bufs[i].state = BUF_IDLE;
+            return;
+        }
+        complete_request(file, tag, res);
+    }
+#else
+    (void)file;
+    (void)i;
+#endif
+}
+
+// Hands buffer i to the kernel at the next file offset
+static void submit_buffer(IoFile *file, int i)
+{
+    IoBuffer *b = &file->bufs[i];
+    b->offset = file->next_offset;
+
+    if (file->writing)
+    {
+        file->next_offset += (long long)b->len;
+        if (file->mode == IO_MODE_STDIO)
+        {
+            if (fwrite(b->data, 1, b->len, file->fp) != b->len)
+                file->error = 1;
+            b->len = 0;
+            return;
+        }
+    }
+    else
+    {
+        file->next_offset += (long long)file->block_size;
+    }
+
+#ifdef IO_HAVE_URING
+    if (file->mode == IO_MODE_URING)
+    {
+        size_t len = file->writing ? b->len : file->block_size;
+        int op = file->writing ? IORING_OP_WRITE : IORING_OP_READ;
+        if (ring_submit(&file->ring, op, file->fd, b->data, len, b->offset, i))
+        {
+            b->state = BUF_BUSY;
+            file->in_flight++;
+            return;
+        }
+        // Submission refused: fall back to synchronous I/O from here on
+        file->mode = IO_MODE_SYNC;
+    }
+#endif
+#ifdef IO_HAVE_POSIX
+    transfer_sync(file, b);
+#endif
+}
+
+// Allocates the IoFile and its aligned staging buffers
+static IoFile *io_alloc(const IoOptions *opts, int writing)
+{
+    IoOptions defaults;
+    if (!opts)
+    {
+        io_default_options(&defaults);
+        opts = &defaults;
+    }
+
+    IoFile *file = (IoFile *)calloc(1, sizeof(IoFile));
+    if (!file)
+        return NULL;
+
+    file->writing = writing;
+    file->fd = -1;
+    file->direct = opts->direct;
+    file->sync = opts->sync;
+    file->block_size = opts->block_size ? opts->block_size : IO_BLOCK_SIZE;
+    file->block_size = (file->block_size + IO_DIRECT_ALIGN - 1) / IO_DIRECT_ALIGN * IO_DIRECT_ALIGN;
+    file->depth = opts->queue_depth > 0 ? opts->queue_depth : IO_QUEUE_DEPTH;
+    file->mode = (opts->kind == IO_BACKEND_URING) ? IO_MODE_URING : IO_MODE_STDIO;
+#ifndef IO_HAVE_POSIX
+    file->mode = IO_MODE_STDIO;
+#endif
+    if (file->mode == IO_MODE_STDIO)
+        file->direct = 0; // stdio always goes through the page cache
+
+    file->bufs = (IoBuffer *)calloc((size_t)file->depth, sizeof(IoBuffer));
+    file->raw = (char *)malloc(file->block_size * (size_t)file->depth + IO_DIRECT_ALIGN);
+    if (!file->bufs || !file->raw)
+    {
+        free(file->bufs);
+        free(file->raw);
+        free(file);
+        return NULL;
+    }
+
+    char *base = (char *)(((uintptr_t)file->raw + IO_DIRECT_ALIGN - 1) & ~(uintptr_t)(IO_DIRECT_ALIGN - 1));
+    for (int i = 0; i < file->depth; i++)
+    {
+        file->bufs[i].data = base + file->block_size * (size_t)i;
+    }
+    return file;
+}
+
+static void io_release(IoFile *file)
+{
+    free(file->bufs);
+    free(file->raw);
+    free(file);
+}
+
+#ifdef IO_HAVE_POSIX
+// Opens the descriptor (with O_DIRECT if asked and supported) and sets up the ring
+static int open_fd(IoFile *file, const char *path, int flags)
+{
+#ifdef O_DIRECT
+    if (file->direct)
+    {
+        file->fd = open(path, flags | O_DIRECT, 0644);
+        if (file->fd < 0 && errno == EINVAL)
+        {
+            // Some filesystems (e.g. tmpfs) reject O_DIRECT; use the page cache instead
+            file->direct = 0;
+        }
+        else if (file->fd < 0)
+        {
+            return 0;
+        }
+    }
+#else
+    file->direct = 0;
+#endif
+    if (file->fd < 0)
+        file->fd = open(path, flags, 0644);
+    if (file->fd < 0)
+        return 0;
+
+    int want_ring = (file->mode == IO_MODE_URING);
+    file->mode = IO_MODE_SYNC;
+#ifdef IO_HAVE_URING
+    if (want_ring && ring_init(&file->ring, (unsigned)file->depth))
+    {
+        file->ring_ready = 1;
+        file->mode = IO_MODE_URING;
+    }
+#else
+    (void)want_ring;
+#endif
+    return 1;
+}
+#endif
+
+// --- Public API ---
+
+void io_default_options(IoOptions *opts)
+{
+    opts->kind = IO_BACKEND_URING;
+    opts->direct = 0;
+    opts->block_size = IO_BLOCK_SIZE;
+    opts->queue_depth = IO_QUEUE_DEPTH;
+    opts->sync = 0;
+}
+
+IoFile *io_open_write(const char *path, const IoOptions *opts)
+{
+    IoFile *file = io_alloc(opts, 1);
+    if (!file)
+        return NULL;
+
+#ifdef IO_HAVE_POSIX
+    if (file->mode != IO_MODE_STDIO)
+    {
+        if (!open_fd(file, path, O_WRONLY | O_CREAT | O_TRUNC))
+        {
+            io_release(file);
+            return NULL;
+        }
+        return file;
+    }
+#endif
+    file->fp = fopen(path, "wb");
+    if (!file->fp)
+    {
+        io_release(file);
+        return NULL;
+    }
+    setvbuf(file->fp, NULL, _IOFBF, file->block_size);
+    return file;
+}
+
+IoFile *io_open_read(const char *path, const IoOptions *opts)
+{
+    IoFile *file = io_alloc(opts, 0);
+    if (!file)
+        return NULL;
+
+#ifdef IO_HAVE_POSIX
+    if (file->mode != IO_MODE_STDIO)
+    {
+        struct stat st;
+        if (!open_fd(file, path, O_RDONLY))
+        {
+            io_release(file);
+            return NULL;
+        }
+        if (fstat(file->fd, &st) == 0)
+            file->file_size = (long long)st.st_size;
+
+        // Read ahead: keep every buffer busy from the start
+        for (int i = 0; i < file->depth && file->next_offset < file->file_size; i++)
+        {
+            submit_buffer(file, i);
+        }
+        return file;
+    }
+#endif
+    file->fp = fopen(path, "rb");
+    if (!file->fp)
+    {
+        io_release(file);
+        return NULL;
+    }
+    setvbuf(file->fp, NULL, _IOFBF, file->block_size);
+    return file;
+}
+
+int io_write(IoFile *file, const void *data, size_t len)
+{
+    const char *src = (const char *)data;
+    while (len > 0)
+    {
+        IoBuffer *b = &file->bufs[file->current];
+        size_t n = file->block_size - b->len;
+        if (n > len)
+            n = len;
+        memcpy(b->data + b->len, src, n);
+        b->len += n;
+        src += n;
+        len -= n;
+        file->file_size += (long long)n;
+
+        if (b->len == file->block_size)
+        {
+            submit_buffer(file, file->current);
+            file->current = (file->current + 1) % file->depth;
+            wait_for_buffer(file, file->current); // Reuse the oldest buffer once it is written
+        }
+    }
+    return !file->error;
+}
+
+size_t io_read(IoFile *file, void *data, size_t len)
+{
+    if (file->mode == IO_MODE_STDIO)
+    {
+        size_t n = fread(data, 1, len, file->fp);
+        if (ferror(file->fp))
+            file->error = 1;
+        return n;
+    }
+
+    char *dst = (char *)data;
+    size_t copied = 0;
+    while (copied < len && !file->error)
+    {
+        IoBuffer *b = &file->bufs[file->current];
+        wait_for_buffer(file, file->current);
+        if (b->state != BUF_READY)
+            break; // Nothing requested here: end of file
+
+        size_t n = b->len - b->pos;
+        if (n > len - copied)
+            n = len - copied;
+        memcpy(dst + copied, b->data + b->pos, n);
+        b->pos += n;
+        copied += n;
+
+        if (b->pos == b->len)
+        {
+            int short_block = b->len < file->block_size;
+            b->state = BUF_IDLE;
+            // Refill this buffer with the next block not yet requested
+            if (!short_block && file->next_offset < file->file_size)
+                submit_buffer(file, file->current);
+            file->current = (file->current + 1) % file->depth;
+            if (short_block)
+                break;
+        }
+    }
+    return copied;
+}
+
+int io_error(const IoFile *file)
+{
+    return file->error;
+}
+
+int io_close(IoFile *file)
+{
+    if (!file)
+        return 0;
+
+    if (file->writing)
+    {
+        IoBuffer *b = &file->bufs[file->current];
+        if (b->len > 0)
+        {
+            // O_DIRECT needs whole aligned blocks; pad now, trim with ftruncate below
+            if (file->direct)
+            {
+                size_t padded = (b->len + IO_DIRECT_ALIGN - 1) / IO_DIRECT_ALIGN * IO_DIRECT_ALIGN;
+                memset(b->data + b->len, 0, padded - b->len);
+                b->len = padded;
+            }
+            submit_buffer(file, file->current);
+        }
+    }
+
+    // Drain everything still in flight (reads included, before buffers are freed)
+    for (int i = 0; i < file->depth; i++)
+    {
+        wait_for_buffer(file, i);
+    }
+
+    int ok = !file->error;
+    if (file->fp)
+    {
+        if (fflush(file->fp) != 0)
+            ok = 0;
+#ifdef IO_HAVE_POSIX
+        if (file->writing && file->sync && fsync(fileno(file->fp)) != 0)
+            ok = 0;
+#endif
+        if (fclose(file->fp) != 0)
+            ok = 0;
+    }
+#ifdef IO_HAVE_POSIX
+    if (file->fd >= 0)
+    {
+        if (file->writing && file->direct && ftruncate(file->fd, (off_t)file->file_size) != 0)
+            ok = 0;
+        if (file->writing && file->sync && fsync(file->fd) != 0)
+            ok = 0;
+#ifdef IO_HAVE_URING
+        if (file->ring_ready)
+            ring_destroy(&file->ring);
+#endif
+        if (close(file->fd) != 0)
+            ok = 0;
+    }
+#endif
+    io_release(file);
+    return ok;
+}
+
+int io_sync_dir(const char *path)
+{
+#ifdef IO_HAVE_POSIX
+    // The directory is everything before the last '/', or "." if there is none
+    char dir[4096];
+    const char *slash = strrchr(path, '/');
+    size_t len = slash ? (size_t)(slash - path) : 0;
+    if (len >= sizeof(dir))
+        return 0;
+    if (slash && len == 0)
+        len = 1; // A file directly under "/"
+    memcpy(dir, slash ? path : ".", slash ? len : 1);
+    dir[slash ? len : 1] = '\0';
+
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    int ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#else
+    (void)path;
+    return 1; // No portable way to sync a directory
+#endif
+}
+
+const char *io_backend_name(const IoFile *file)
+{
+    switch (file->mode)
+    {
+    case IO_MODE_URING:
+        return file->direct ? "io_uring, O_DIRECT" : "io_uring";
+    case IO_MODE_SYNC:
+        return file->direct ? "pread/pwrite, O_DIRECT" : "pread/pwrite";
+    default:
+        return "stdio";
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef IOBACKEND_H
+#define IOBACKEND_H
+
+#include <stddef.h> // size_t
+
+// --- Tunable Parameters ---
+// Size of each I/O request. Large requests let NVMe drives reach full bandwidth.
+#define IO_BLOCK_SIZE (1024 * 1024)
+// Requests kept in flight while the caller serializes or decodes the next block
+#define IO_QUEUE_DEPTH 4
+// Alignment required for O_DIRECT buffers, offsets and lengths
+#define IO_DIRECT_ALIGN 4096
+// -------------------------
+
+typedef enum
+{
+    IO_BACKEND_STDIO = 0, // Portable buffered stdio (fwrite/fread)
+    IO_BACKEND_URING      // io_uring on Linux, synchronous pread/pwrite if the ring is unavailable
+} IoBackendKind;
+
+typedef struct
+{
+    IoBackendKind kind;
+    int direct;         // Open with O_DIRECT (bypass the page cache); ignored by IO_BACKEND_STDIO
+    size_t block_size;  // Bytes per request (0 = IO_BLOCK_SIZE), rounded to IO_DIRECT_ALIGN
+    int queue_depth;    // Requests in flight (0 = IO_QUEUE_DEPTH)
+    int sync;           // Writers: fsync in io_close so the data is on stable storage
+} IoOptions;
+
+// Sequential writer/reader. Data is staged in aligned blocks that are handed to
+// the kernel as soon as they fill, so the caller keeps producing (or consuming)
+// the next block while earlier ones are still being written (or read).
+typedef struct IoFile IoFile;
+
+void io_default_options(IoOptions *opts);
+IoFile *io_open_write(const char *path, const IoOptions *opts); // Creates or truncates path
+IoFile *io_open_read(const char *path, const IoOptions *opts);  // NULL if path cannot be opened
+int io_write(IoFile *file, const void *data, size_t len);      // Returns 1 on success
+size_t io_read(IoFile *file, void *data, size_t len);          // Bytes copied (< len at EOF or error)
+int io_error(const IoFile *file);                              // Non-zero once any request failed
+int io_close(IoFile *file);                                    // Flushes writes; returns 1 if all I/O succeeded
+int io_sync_dir(const char *path);                             // fsyncs the directory holding path (after a rename)
+const char *io_backend_name(const IoFile *file);               // Backend actually in use
+
+#endif // IOBACKEND_H
@@ -6,76 +6,356 @@
 #include "skiplist.h"
 #include "record.h"
 #include "persistence.h"
+#include "replication.h"
+#include "trace.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <unistd.h> // STDIN_FILENO
+#endif
 
 #define INPUT_BUFFER_SIZE 256
 #define DB_FILENAME "crud_database.bin"
+#define MGET_MAX_IDS (INPUT_BUFFER_SIZE / 2) // "1 2 3 ..." cannot hold more
+#define TRACE_FILENAME "trace.json"
+
+// Per-command phase timings (NULL until tracing is first turned on)
+static Tracer *tracer = NULL;
 
 void print_help()
 {
     printf("\n--- C-CRUD SkipList DB ---\n");
     printf("Commands:\n");
-    printf("  add <id> <name> <value>  - Add a new record\n");
+    printf("  add <id> <name> <value> [ttl] - Add a new record (expiring after ttl seconds)\n");
     printf("  get <id>               - Retrieve a record by ID\n");
+    printf("  mget <id> [id...]      - Retrieve several records in one batched lookup\n");
     printf("  del <id>               - Delete a record by ID\n");
     printf("  update <id> <name> <val>- Update record (name/value)\n");
     printf("  save [filename]        - Save DB (default: %s)\n", DB_FILENAME);
     printf("  load [filename]        - Load DB (default: %s)\n", DB_FILENAME);
+    printf("  merge <file> [mode]    - Combine with a saved DB. take (default) / keep: add its records,\n");
+    printf("                           replacing / keeping existing IDs; and: keep only IDs in both;\n");
+    printf("                           not: drop IDs found in the file\n");
+    printf("  split <id> <file>      - Move records with ID >= id out into a saved DB\n");
     printf("  list                   - Display skip list levels (debug)\n");
+    printf("  agg <lo> <hi>          - Count/sum/min/max/avg of values for IDs in [lo, hi]\n");
+    printf("  promote <id>           - Raise a hot record's tower to the top level\n");
+    printf("  expire <id> <seconds>  - Set a record's TTL (0 = never expire)\n");
+    printf("  ttl <id>               - Show the seconds a record has left\n");
     printf("  stats                  - Show list size and height\n");
+    printf("  memstats               - Show memory used, by category\n");
+    printf("  trace [on|off|dump [file]] - Per-command phase timings; dump writes Chrome trace JSON\n");
     printf("  bulkadd <count>        - Add N random records for testing\n");
     printf("  help                   - Show this help message\n");
     printf("  quit                   - Exit the application\n");
     printf("--------------------------\n");
 }
 
-// Helper to measure time
+void print_usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [options]\n", prog);
+    fprintf(stderr, "  --arena                        - Allocate nodes/records from an mmap'd arena\n");
+    fprintf(stderr, "  --hugepages <off|thp|explicit> - Arena page backing (implies --arena)\n");
+    fprintf(stderr, "  --numa-node <n>                - Bind arena memory to NUMA node n (implies --arena)\n");
+    fprintf(stderr, "  --p <prob>                     - Level probability (default %.2f)\n", SKIPLIST_P);
+    fprintf(stderr, "  --cache <entries>              - Hot-key lookaside cache in front of get\n");
+    fprintf(stderr, "  --filter                       - Cuckoo filter to skip descents for absent IDs\n");
+    fprintf(stderr, "  --column                       - Columnar copy of values for fast 'agg' queries\n");
+    fprintf(stderr, "  --io <stdio|uring>             - Persistence I/O backend (default uring)\n");
+    fprintf(stderr, "  --direct                       - Use O_DIRECT for save/load (uring backend)\n");
+    fprintf(stderr, "  --compact                      - Store each record inside its node\n");
+    fprintf(stderr, "  --deterministic                - Balanced 1-2-3 towers instead of random levels\n");
+    fprintf(stderr, "  --leader <socket>              - Stream every change to followers on a Unix socket\n");
+    fprintf(stderr, "  --follow <socket>              - Read-only replica of the leader on a Unix socket\n");
+    fprintf(stderr, "  --trace                        - Start with per-command phase tracing on\n");
+}
+
+// Turns tracing on or off, creating the tracer the first time. Returns 0 if it cannot be created.
+int set_tracing(int on)
+{
+    if (!tracer && on && !(tracer = trace_create()))
+    {
+        fprintf(stderr, "Error: could not allocate the trace buffer.\n");
+        return 0;
+    }
+    if (tracer)
+        tracer->enabled = on;
+    return 1;
+}
+
+// Parses startup flags into list, I/O and replication options. Returns 0 on an unknown or incomplete flag.
+int parse_args(int argc, char *argv[], SkipListOptions *opts, IoOptions *io, ReplRole *role, const char **repl_path)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--arena") == 0)
+        {
+            opts->use_arena = 1;
+        }
+        else if (strcmp(argv[i], "--hugepages") == 0 && i + 1 < argc)
+        {
+            const char *mode = argv[++i];
+            opts->use_arena = 1;
+            if (strcmp(mode, "off") == 0)
+                opts->arena.page_mode = ARENA_PAGES_DEFAULT;
+            else if (strcmp(mode, "thp") == 0)
+                opts->arena.page_mode = ARENA_PAGES_TRANSPARENT;
+            else if (strcmp(mode, "explicit") == 0)
+                opts->arena.page_mode = ARENA_PAGES_EXPLICIT;
+            else
+                return 0;
+        }
+        else if (strcmp(argv[i], "--numa-node") == 0 && i + 1 < argc)
+        {
+            opts->use_arena = 1;
+            opts->arena.numa_node = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+        {
+            long entries = atol(argv[++i]);
+            if (entries <= 0)
+                return 0;
+            opts->cache_entries = (size_t)entries;
+        }
+        else if (strcmp(argv[i], "--filter") == 0)
+        {
+            opts->use_filter = 1;
+        }
+        else if (strcmp(argv[i], "--column") == 0)
+        {
+            opts->use_column = 1;
+        }
+        else if (strcmp(argv[i], "--io") == 0 && i + 1 < argc)
+        {
+            const char *kind = argv[++i];
+            if (strcmp(kind, "stdio") == 0)
+                io->kind = IO_BACKEND_STDIO;
+            else if (strcmp(kind, "uring") == 0)
+                io->kind = IO_BACKEND_URING;
+            else
+                return 0;
+        }
+        else if (strcmp(argv[i], "--direct") == 0)
+        {
+            io->direct = 1;
+        }
+        else if (strcmp(argv[i], "--compact") == 0)
+        {
+            opts->compact = 1;
+        }
+        else if (strcmp(argv[i], "--deterministic") == 0)
+        {
+            opts->deterministic = 1;
+        }
+        else if (strcmp(argv[i], "--trace") == 0)
+        {
+            if (!set_tracing(1))
+                return 0;
+        }
+        else if ((strcmp(argv[i], "--leader") == 0 || strcmp(argv[i], "--follow") == 0) && i + 1 < argc)
+        {
+            *role = (argv[i][2] == 'l') ? REPL_LEADER : REPL_FOLLOWER;
+            *repl_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--p") == 0 && i + 1 < argc)
+        {
+            opts->p = atof(argv[++i]);
+            if (opts->p <= 0.0 || opts->p >= 1.0)
+                return 0;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Prints skiplist_memory() as a table
+void print_memory(SkipList *list)
+{
+    SkipListMemory mem;
+    skiplist_memory(list, &mem);
+    printf("Memory Usage (bytes):\n");
+    printf("  List + Header     : %12lu\n", (unsigned long)mem.list);
+    printf("  Node Fields       : %12lu\n", (unsigned long)mem.node_fields);
+    printf("  Forward Pointers  : %12lu\n", (unsigned long)mem.forward_pointers);
+    printf("  Records           : %12lu%s\n", (unsigned long)mem.records, list->compact ? " (inside nodes)" : "");
+    printf("  Allocator Overhead: %12lu%s\n", (unsigned long)mem.allocator, list->arena ? " (arena)" : "");
+    printf("  Cache             : %12lu\n", (unsigned long)mem.cache);
+    printf("  Filter            : %12lu\n", (unsigned long)mem.filter);
+    printf("  Column            : %12lu\n", (unsigned long)mem.column);
+    printf("  TTL Wheel         : %12lu\n", (unsigned long)mem.ttl);
+    printf("  Total             : %12lu", (unsigned long)mem.total);
+    if (list->size > 0)
+        printf(" (%.1f per record)", (double)mem.total / (double)list->size);
+    printf("\n");
+    if (mem.shared_arena)
+        printf("  Shared Arena      : %12lu (other nodes and unused space, not in total)\n",
+               (unsigned long)mem.shared_arena);
+}
+
+// Queues a change for the followers when this instance is a replication leader
+void publish_change(Replicator *repl, ReplOpKind op, int id, const char *name, double value, time_t expires_at)
+{
+    if (!repl)
+        return;
+    // Resume whatever the change interrupted (output, or the lookups of bulkadd)
+    TracePhase resume = (tracer && tracer->open) ? tracer->phase : TRACE_OUTPUT;
+    trace_phase(tracer, TRACE_REPLICATE);
+    Record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.id = id;
+    if (name)
+        strncpy(rec.name, name, MAX_NAME_LEN - 1);
+    rec.value = value;
+    repl_publish(repl, op, &rec, expires_at);
+    trace_phase(tracer, resume);
+}
+
+// Followers only change through the replication stream
+int reject_on_follower(Replicator *repl)
+{
+    if (repl && repl->role == REPL_FOLLOWER)
+    {
+        printf("Error: this instance is a read-only follower of %s.\n", repl->path);
+        return 1;
+    }
+    return 0;
+}
+
+// Blocks until a command can be read, servicing replication in the meantime
+void wait_for_command(Replicator *repl, SkipList **list, const SkipListOptions *opts)
+{
+    if (!repl)
+        return;
+    repl_flush(repl);
+#if defined(__unix__) || defined(__APPLE__)
+    fflush(stdout);
+    while (1)
+    {
+        struct pollfd fds[2];
+        fds[0].fd = STDIN_FILENO;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = repl_poll_fd(repl);
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        int nfds = fds[1].fd >= 0 ? 2 : 1;
+        if (poll(fds, (nfds_t)nfds, repl_poll_timeout(repl)) < 0)
+            return; // Let fgets report the problem
+
+        if (nfds == 1 || fds[1].revents || repl->fd < 0)
+            repl_service(repl, list, opts);
+        if (fds[0].revents)
+            return;
+    }
+#else
+    repl_service(repl, list, opts);
+#endif
+}
+
+// Helper to measure time (wall clock, so waiting on I/O counts too)
 typedef struct
 {
-    clock_t start;
-    clock_t end;
+    uint64_t start;
+    uint64_t end;
 } Timer;
 
-void start_timer(Timer *t)
+// Starts timing the core of a command, which the trace records as the given phase
+void start_timer(Timer *t, TracePhase phase)
 {
-    t->start = clock();
+    trace_phase(tracer, phase);
+    t->start = trace_now_ns();
 }
 
+// Stops the timer; what follows is traced as output
 double stop_timer(Timer *t)
 {
-    t->end = clock();
-    return ((double)(t->end - t->start)) / CLOCKS_PER_SEC;
+    t->end = trace_now_ns();
+    trace_phase(tracer, TRACE_OUTPUT);
+    return (double)(t->end - t->start) / 1e9;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
     char input[INPUT_BUFFER_SIZE];
-    char command[32];
+    char command[32] = "";
     char filename_buf[INPUT_BUFFER_SIZE]; // Buffer for optional filenames
     Timer timer;                          // For timing operations
+    SkipListOptions db_options;           // Applied to every list this session creates
+    IoOptions io_options;                 // Backend used by save/load
+    ReplRole repl_role = REPL_NONE;       // Replication role chosen at startup
+    const char *repl_path = NULL;         // Socket the leader listens on / the follower connects to
+    Replicator *repl = NULL;
+
+    skiplist_default_options(&db_options);
+    io_default_options(&io_options);
+    if (!parse_args(argc, argv, &db_options, &io_options, &repl_role, &repl_path))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
 
     // --- Initialization ---
-    printf("Loading database...\n");
-    SkipList *db_list = load_database(DB_FILENAME);
+    srand((unsigned int)time(NULL)); // Seeds each new list's tower generator and the populate command
+    SkipList *db_list;
+    if (repl_role == REPL_FOLLOWER)
+    {
+        // A follower's data comes from the leader's snapshot, not from the database file
+        db_list = create_skiplist_ex(&db_options);
+        if (db_list && !(repl = repl_follower_create(repl_path)))
+        {
+            free_skiplist(db_list);
+            return 1;
+        }
+    }
+    else
+    {
+        printf("Loading database...\n");
+        db_list = load_database_ex(DB_FILENAME, &db_options, &io_options);
+        if (db_list && repl_role == REPL_LEADER && !(repl = repl_leader_create(repl_path)))
+        {
+            free_skiplist(db_list);
+            return 1;
+        }
+    }
     if (!db_list)
     {
         fprintf(stderr, "Fatal: Could not initialize database.\n");
         return 1;
     }
+    if (repl)
+    {
+        // Unbuffered, so poll() on stdin sees every pending line
+        setvbuf(stdin, NULL, _IONBF, 0);
+        printf("Replication %s on %s.\n", repl_role == REPL_LEADER ? "leader listening" : "follower connected",
+               repl_path);
+    }
     printf("Database ready. Type 'help' for commands.\n");
     // ---------------------
 
     while (1)
     {
+        trace_command_end(tracer, command); // The previous command, if it was traced
         printf("> ");
+        wait_for_command(repl, &db_list, &db_options);
         if (!fgets(input, INPUT_BUFFER_SIZE, stdin))
         {
             printf("Error reading input or EOF reached. Exiting.\n");
             break; // Exit on read error or EOF
         }
+        trace_command_begin(tracer);
+        command[0] = '\0';
 
         // Remove trailing newline
         input[strcspn(input, "\n")] = 0;
 
+        // Every command also reclaims a few expired records
+        trace_phase(tracer, TRACE_LOOKUP);
+        skiplist_reap(db_list, TTL_REAP_PER_OP);
+        trace_phase(tracer, TRACE_PARSE);
+
         // Basic command parsing
         int id;
         char name[MAX_NAME_LEN];
@@ -98,34 +378,46 @@ int main()
         }
         else if (strcmp(command, "add") == 0)
         {
-            items_scanned = sscanf(input, "%*s %d %63s %lf", &id, name, &value);
-            if (items_scanned == 3)
+            long ttl = 0;
+            items_scanned = sscanf(input, "%*s %d %63s %lf %ld", &id, name, &value, &ttl);
+            if (reject_on_follower(repl))
+                continue;
+            if (items_scanned >= 3 && ttl >= 0)
             {
                 if (id < 0)
                 {
                     printf("Error: ID must be non-negative.\n");
                     continue;
                 }
-                Record *new_rec = create_record(id, name, value);
+                trace_phase(tracer, TRACE_ALLOC);
+                Record *new_rec = create_record_in(db_list->arena, id, name, value);
                 if (new_rec)
                 {
-                    start_timer(&timer);
+                    start_timer(&timer, TRACE_LOOKUP);
                     int success = insert_skiplist(db_list, id, new_rec);
                     double elapsed = stop_timer(&timer);
                     if (success)
                     {
+                        time_t expires_at = (ttl > 0) ? time(NULL) + ttl : 0;
+                        if (expires_at && !skiplist_expire_at(db_list, id, expires_at))
+                        {
+                            // Followers must not expire a record the leader keeps
+                            printf("Warning: Could not set the TTL of record ID %d (memory error?); it does not expire.\n", id);
+                            expires_at = 0;
+                        }
+                        publish_change(repl, REPL_OP_ADD, id, name, value, expires_at);
                         printf("Record ID %d added successfully. (%.6f s)\n", id, elapsed);
                     }
                     else
                     {
                         printf("Error: Failed to add record ID %d (duplicate or memory error?).\n", id);
-                        free(new_rec); // Important: free the record if insertion failed
+                        free_record_in(db_list->arena, new_rec); // Important: free the record if insertion failed
                     }
                 }
             }
             else
             {
-                printf("Usage: add <id> <name> <value>\n");
+                printf("Usage: add <id> <name> <value> [ttl_seconds]\n");
             }
         }
         else if (strcmp(command, "get") == 0)
@@ -133,7 +425,7 @@ int main()
             items_scanned = sscanf(input, "%*s %d", &id);
             if (items_scanned == 1)
             {
-                start_timer(&timer);
+                start_timer(&timer, TRACE_LOOKUP);
                 Record *rec = search_skiplist(db_list, id);
                 double elapsed = stop_timer(&timer);
                 if (rec)
@@ -151,16 +443,57 @@ int main()
                 printf("Usage: get <id>\n");
             }
         }
+        else if (strcmp(command, "mget") == 0)
+        {
+            int ids[MGET_MAX_IDS];
+            Record *recs[MGET_MAX_IDS];
+            size_t count = 0;
+            char *cursor = input + strcspn(input, " \t"); // Skip the command word
+            char *end;
+            for (long parsed = strtol(cursor, &end, 10); end != cursor && count < MGET_MAX_IDS;
+                 parsed = strtol(cursor, &end, 10))
+            {
+                ids[count++] = (int)parsed;
+                cursor = end;
+            }
+            if (count > 0 && cursor[strspn(cursor, " \t")] == '\0')
+            {
+                start_timer(&timer, TRACE_LOOKUP);
+                skiplist_search_batch(db_list, ids, count, recs);
+                double elapsed = stop_timer(&timer);
+                size_t found = 0;
+                for (size_t i = 0; i < count; i++)
+                {
+                    if (recs[i])
+                    {
+                        print_record(recs[i]);
+                        found++;
+                    }
+                    else
+                    {
+                        printf("Record ID %d not found.\n", ids[i]);
+                    }
+                }
+                printf("%lu of %lu records found. (%.6f s)\n", (unsigned long)found, (unsigned long)count, elapsed);
+            }
+            else
+            {
+                printf("Usage: mget <id> [id...]\n");
+            }
+        }
         else if (strcmp(command, "del") == 0)
         {
+            if (reject_on_follower(repl))
+                continue;
             items_scanned = sscanf(input, "%*s %d", &id);
             if (items_scanned == 1)
             {
-                start_timer(&timer);
+                start_timer(&timer, TRACE_LOOKUP);
                 int success = delete_skiplist(db_list, id);
                 double elapsed = stop_timer(&timer);
                 if (success)
                 {
+                    publish_change(repl, REPL_OP_DEL, id, NULL, 0.0, 0);
                     printf("Record ID %d deleted successfully. (%.6f s)\n", id, elapsed);
                 }
                 else
@@ -175,23 +508,22 @@ int main()
         }
         else if (strcmp(command, "update") == 0)
         {
+            if (reject_on_follower(repl))
+                continue;
             items_scanned = sscanf(input, "%*s %d %63s %lf", &id, name, &value);
             if (items_scanned == 3)
             {
-                start_timer(&timer);
-                Record *rec = search_skiplist(db_list, id);
+                start_timer(&timer, TRACE_LOOKUP);
+                int success = update_skiplist(db_list, id, name, value);
                 double elapsed = stop_timer(&timer);
-                if (rec)
+                if (success)
                 {
-                    // Update in-place (key doesn't change)
-                    strncpy(rec->name, name, MAX_NAME_LEN - 1);
-                    rec->name[MAX_NAME_LEN - 1] = '\0';
-                    rec->value = value;
-                    printf("Record ID %d updated successfully. (Search took %.6f s)\n", id, elapsed);
+                    publish_change(repl, REPL_OP_UPDATE, id, name, value, 0);
+                    printf("Record ID %d updated successfully. (%.6f s)\n", id, elapsed);
                 }
                 else
                 {
-                    printf("Error: Record ID %d not found for update. (Search took %.6f s)\n", id, elapsed);
+                    printf("Error: Record ID %d not found for update. (%.6f s)\n", id, elapsed);
                 }
             }
             else
@@ -207,13 +539,15 @@ int main()
             {
                 filename_to_save = filename_buf;
             }
-            start_timer(&timer);
-            save_database(db_list, filename_to_save);
+            start_timer(&timer, TRACE_PERSIST);
+            save_database_ex(db_list, filename_to_save, &io_options);
             double elapsed = stop_timer(&timer);
             printf("Save operation took %.6f s.\n", elapsed);
         }
         else if (strcmp(command, "load") == 0)
         {
+            if (reject_on_follower(repl))
+                continue;
             const char *filename_to_load = DB_FILENAME;
             items_scanned = sscanf(input, "%*s %255s", filename_buf);
             if (items_scanned == 1)
@@ -226,40 +560,306 @@ int main()
             if (fgets(input, INPUT_BUFFER_SIZE, stdin) && (input[0] == 'y' || input[0] == 'Y'))
             {
                 printf("Loading from %s...\n", filename_to_load);
-                start_timer(&timer);
-                free_skiplist(db_list); // Free the old list first
-                db_list = load_database(filename_to_load);
+                start_timer(&timer, TRACE_PERSIST);
+                SkipList *loaded = load_database_ex(filename_to_load, &db_options, &io_options);
                 double elapsed = stop_timer(&timer);
-                if (!db_list)
+                if (!loaded)
                 {
-                    fprintf(stderr, "Fatal: Load failed, could not re-initialize database.\n");
-                    return 1; // Critical error
+                    // Damaged file (or out of memory): keep serving the current data
+                    printf("Load failed; the current database was kept.\n");
+                    continue;
                 }
+                free_skiplist(db_list); // Replace the old list only once the new one is complete
+                db_list = loaded;
                 printf("Load operation took %.6f s.\n", elapsed);
+                repl_snapshot_all(repl, db_list); // Followers start over from the loaded data
             }
             else
             {
                 printf("Load cancelled.\n");
             }
         }
+        else if (strcmp(command, "merge") == 0)
+        {
+            if (reject_on_follower(repl))
+                continue;
+            char mode[16] = "take";
+            items_scanned = sscanf(input, "%*s %255s %15s", filename_buf, mode);
+            int known = strcmp(mode, "take") == 0 || strcmp(mode, "keep") == 0 ||
+                        strcmp(mode, "and") == 0 || strcmp(mode, "not") == 0;
+            if (items_scanned < 1 || !known)
+            {
+                printf("Usage: merge <file> [take|keep|and|not]\n");
+                continue;
+            }
+            FILE *probe = fopen(filename_buf, "rb"); // A missing file would load as an empty list
+            if (!probe)
+            {
+                perror("Error opening file for merging");
+                continue;
+            }
+            fclose(probe);
+
+            // The other list is only walked once, so it needs no cache, filter or column
+            SkipListOptions other_options;
+            skiplist_default_options(&other_options);
+            other_options.p = db_options.p;
+            other_options.compact = db_options.compact;
+
+            start_timer(&timer, TRACE_PERSIST);
+            SkipList *other = load_database_ex(filename_buf, &other_options, &io_options);
+            double load_elapsed = stop_timer(&timer);
+            if (!other)
+            {
+                printf("Merge failed; the current database was kept.\n");
+                continue;
+            }
+
+            size_t before = db_list->size;
+            size_t count;
+            start_timer(&timer, TRACE_LOOKUP);
+            if (strcmp(mode, "and") == 0)
+                count = skiplist_intersect(db_list, other);
+            else if (strcmp(mode, "not") == 0)
+                count = skiplist_subtract(db_list, other);
+            else
+                count = skiplist_merge(db_list, other, strcmp(mode, "keep") == 0 ? SKIPLIST_KEEP_DEST : SKIPLIST_TAKE_SOURCE);
+            double elapsed = stop_timer(&timer);
+            free_skiplist(other);
+
+            if (strcmp(mode, "and") == 0 || strcmp(mode, "not") == 0)
+                printf("%lu records removed", (unsigned long)count);
+            else
+                printf("%lu records taken from %s", (unsigned long)count, filename_buf);
+            printf(" (%lu -> %lu records). Load %.6f s, merge %.6f s.\n", (unsigned long)before,
+                   (unsigned long)db_list->size, load_elapsed, elapsed);
+            repl_snapshot_all(repl, db_list); // Cheaper for followers to resync than to replay the diff
+        }
+        else if (strcmp(command, "split") == 0)
+        {
+            if (reject_on_follower(repl))
+                continue;
+            items_scanned = sscanf(input, "%*s %d %255s", &id, filename_buf);
+            if (items_scanned != 2)
+            {
+                printf("Usage: split <id> <file>\n");
+                continue;
+            }
+            start_timer(&timer, TRACE_LOOKUP);
+            SkipList *upper = skiplist_split(db_list, id);
+            double elapsed = stop_timer(&timer);
+            if (!upper)
+            {
+                printf("Error: Split failed (out of memory); nothing was moved.\n");
+                continue;
+            }
+            printf("Split off %lu records with ID >= %d (%.6f s).\n", (unsigned long)upper->size, id, elapsed);
+            trace_phase(tracer, TRACE_PERSIST);
+            int saved = save_database_ex(upper, filename_buf, &io_options);
+            if (!saved && skiplist_concat(db_list, upper))
+            {
+                printf("Save failed; the records were kept.\n"); // The range was taken back
+            }
+            else
+            {
+                if (!saved) // concat ran out of memory and left the range in upper
+                    printf("Save failed and the records could not be taken back (out of memory); "
+                           "%lu records with ID >= %d were lost.\n", (unsigned long)upper->size, id);
+                repl_snapshot_all(repl, db_list);
+            }
+            free_skiplist(upper);
+        }
         else if (strcmp(command, "list") == 0)
         {
             display_skiplist_levels(db_list);
         }
+        else if (strcmp(command, "agg") == 0)
+        {
+            int lo, hi;
+            items_scanned = sscanf(input, "%*s %d %d", &lo, &hi);
+            if (items_scanned == 2 && lo <= hi)
+            {
+                Aggregate agg;
+                start_timer(&timer, TRACE_LOOKUP);
+                skiplist_aggregate(db_list, lo, hi, &agg);
+                double elapsed = stop_timer(&timer);
+                printf("Aggregate over IDs [%d, %d] (%.6f s%s):\n", lo, hi, elapsed,
+                       db_list->column ? ", columnar" : "");
+                printf("  Count: %lu\n", (unsigned long)agg.count);
+                if (agg.count > 0)
+                {
+                    printf("  Sum  : %.2f\n", agg.sum);
+                    printf("  Min  : %.2f\n", agg.min);
+                    printf("  Max  : %.2f\n", agg.max);
+                    printf("  Avg  : %.2f\n", agg.sum / (double)agg.count);
+                }
+            }
+            else
+            {
+                printf("Usage: agg <lo> <hi> (lo <= hi)\n");
+            }
+        }
+        else if (strcmp(command, "promote") == 0)
+        {
+            items_scanned = sscanf(input, "%*s %d", &id);
+            if (items_scanned == 1)
+            {
+                start_timer(&timer, TRACE_LOOKUP);
+                int success = skiplist_promote(db_list, id);
+                double elapsed = stop_timer(&timer);
+                if (success)
+                {
+                    printf("Record ID %d promoted to level %d. (%.6f s)\n", id, db_list->level, elapsed);
+                }
+                else if (db_list->deterministic)
+                {
+                    printf("Error: towers are fixed by the 1-2-3 rule in deterministic mode.\n");
+                }
+                else
+                {
+                    printf("Error: Record ID %d not found. (%.6f s)\n", id, elapsed);
+                }
+            }
+            else
+            {
+                printf("Usage: promote <id>\n");
+            }
+        }
+        else if (strcmp(command, "expire") == 0)
+        {
+            if (reject_on_follower(repl))
+                continue;
+            long seconds;
+            items_scanned = sscanf(input, "%*s %d %ld", &id, &seconds);
+            if (items_scanned == 2 && seconds >= 0)
+            {
+                time_t expires_at = (seconds > 0) ? time(NULL) + seconds : 0;
+                if (skiplist_expire_at(db_list, id, expires_at))
+                {
+                    publish_change(repl, REPL_OP_EXPIRE, id, NULL, 0.0, expires_at);
+                    if (seconds > 0)
+                        printf("Record ID %d expires in %ld s.\n", id, seconds);
+                    else
+                        printf("Record ID %d no longer expires.\n", id);
+                }
+                else
+                {
+                    printf("Error: Record ID %d not found.\n", id);
+                }
+            }
+            else
+            {
+                printf("Usage: expire <id> <seconds> (0 = never expire)\n");
+            }
+        }
+        else if (strcmp(command, "ttl") == 0)
+        {
+            items_scanned = sscanf(input, "%*s %d", &id);
+            if (items_scanned == 1)
+            {
+                long left = skiplist_ttl(db_list, id);
+                if (left == -2)
+                    printf("Record ID %d not found.\n", id);
+                else if (left == -1)
+                    printf("Record ID %d has no TTL.\n", id);
+                else
+                    printf("Record ID %d expires in %ld s.\n", id, left);
+            }
+            else
+            {
+                printf("Usage: ttl <id>\n");
+            }
+        }
         else if (strcmp(command, "stats") == 0)
         {
             printf("Database Stats:\n");
             printf("  Record Count: %lu\n", (unsigned long)db_list->size);
             printf("  Current Max Level: %d (0-based)\n", db_list->level);
+            printf("  Level Cap: %d (grows with size, limit %d)\n", db_list->max_level, MAX_LEVEL);
+            if (db_list->deterministic)
+                printf("  Balancing: deterministic (1-2-3 gaps)\n");
+            else
+                printf("  Level Probability p: %.3f (observed %.3f)\n", db_list->p, skiplist_observed_p(db_list));
+            printf("  Append Fast Path Hits: %lu\n", (unsigned long)db_list->append_hits);
+            if (db_list->cache)
+            {
+                KeyCache *cache = db_list->cache;
+                printf("  Cache: %lu entries, %lu hits, %lu misses (hit rate %.1f%%), %lu invalidations\n",
+                       (unsigned long)cache_capacity(cache), (unsigned long)cache->hits,
+                       (unsigned long)cache->misses, 100.0 * cache_hit_rate(cache),
+                       (unsigned long)cache->invalidations);
+            }
+            if (db_list->filter)
+            {
+                CuckooFilter *filter = db_list->filter;
+                printf("  Filter: %lu keys in %lu slots, %lu absent probes short-circuited\n",
+                       (unsigned long)filter->count, (unsigned long)cuckoo_slots(filter),
+                       (unsigned long)filter->negatives);
+                printf("  Filter False Positives: %lu (observed rate %.4f, expected %.4f)\n",
+                       (unsigned long)filter->false_positives, cuckoo_observed_fpr(filter),
+                       cuckoo_expected_fpr(filter));
+            }
+            if (db_list->ttl)
+            {
+                printf("  TTL: %lu deadlines queued, %lu records expired and reclaimed\n",
+                       (unsigned long)db_list->ttl->pending, (unsigned long)db_list->ttl->expired);
+            }
+            if (repl)
+            {
+                print_repl_stats(repl);
+            }
+            if (db_list->arena)
+            {
+                print_arena_stats(db_list->arena);
+            }
+        }
+        else if (strcmp(command, "memstats") == 0)
+        {
+            print_memory(db_list);
+        }
+        else if (strcmp(command, "trace") == 0)
+        {
+            char action[16] = "";
+            items_scanned = sscanf(input, "%*s %15s %255s", action, filename_buf);
+            if (items_scanned < 1)
+            {
+                if (tracer)
+                    print_trace_stats(tracer);
+                else
+                    printf("Tracing is off. Use 'trace on' to start.\n");
+            }
+            else if (strcmp(action, "on") == 0 || strcmp(action, "off") == 0)
+            {
+                int on = strcmp(action, "on") == 0;
+                if (set_tracing(on))
+                    printf("Tracing %s.\n", on ? "on (from the next command)" : "off");
+            }
+            else if (strcmp(action, "dump") == 0)
+            {
+                const char *path = items_scanned == 2 ? filename_buf : TRACE_FILENAME;
+                if (!tracer)
+                    printf("Nothing traced yet.\n");
+                else if (trace_dump_chrome(tracer, path))
+                    printf("Wrote %lu trace events to %s (open in chrome://tracing or Perfetto).\n",
+                           (unsigned long)tracer->count, path);
+                else
+                    perror("Error writing trace file");
+            }
+            else
+            {
+                printf("Usage: trace [on|off|dump [file]]\n");
+            }
         }
         else if (strcmp(command, "bulkadd") == 0)
         {
+            if (reject_on_follower(repl))
+                continue;
             int count = 0;
             items_scanned = sscanf(input, "%*s %d", &count);
             if (items_scanned == 1 && count > 0)
             {
                 printf("Adding %d random records...\n", count);
-                start_timer(&timer);
+                start_timer(&timer, TRACE_LOOKUP);
                 int added_count = 0;
                 int attempted_id = (db_list->size > 0) ? (rand() % (db_list->size * 5)) : 0; // Start somewhere random
                 for (int i = 0; i < count;)
@@ -272,15 +872,16 @@ int main()
 
                     sprintf(name, "RandomName_%d", attempted_id);
                     value = (double)(rand() % 100000) / 100.0;
-                    Record *rec = create_record(attempted_id, name, value);
+                    Record *rec = create_record_in(db_list->arena, attempted_id, name, value);
                     if (rec && insert_skiplist(db_list, rec->id, rec))
                     {
+                        publish_change(repl, REPL_OP_ADD, attempted_id, name, value, 0);
                         added_count++;
                         i++; // Only increment loop counter on successful add
                     }
                     else if (rec)
                     {
-                        free(rec); // Free if insert failed (shouldn't happen with check above)
+                        free_record_in(db_list->arena, rec); // Free if insert failed (shouldn't happen with check above)
                     }
                     attempted_id++; // Move to next potential ID
                     if (i > 0 && i % 10000 == 0)
@@ -304,8 +905,14 @@ int main()
     }
 
     // --- Cleanup ---
-    printf("Exiting. Saving database to %s...\n", DB_FILENAME);
-    save_database(db_list, DB_FILENAME); // Auto-save on exit
+    trace_command_end(tracer, command);
+    if (repl_role != REPL_FOLLOWER) // The leader owns the database file
+    {
+        printf("Exiting. Saving database to %s...\n", DB_FILENAME);
+        save_database_ex(db_list, DB_FILENAME, &io_options); // Auto-save on exit
+    }
+    repl_destroy(repl);
+    trace_destroy(tracer);
     free_skiplist(db_list);
     printf("Cleanup complete. Goodbye!\n");
     // ---------------
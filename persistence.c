@@ -1,15 +1,160 @@
 #include "persistence.h"
 #include "record.h" // Need MAX_NAME_LEN
+#include "iobackend.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h> // _mm_crc32_u64
+#endif
+
+// Marks the optional section after the records that lists record deadlines.
+// It is only written once a TTL has been set, so files without TTLs are unchanged.
+#define TTL_SECTION_MAGIC 0x314C5454u // "TTL1"
+// Marks the trailer: a CRC32C of every byte before the marker. Always written last.
+#define CRC_TRAILER_MAGIC 0x31435243u // "CRC1"
+// Suffix of the file a save writes before renaming it over the real one
+#define TEMP_SUFFIX ".tmp"
+
+// --- CRC32C (Castagnoli) ---
+
+#if !defined(__SSE4_2__)
+static uint32_t crc_table[8][256]; // Slicing-by-8 tables for the reflected polynomial
+static int crc_table_state = 0;    // 0 = not built, 1 = being built, 2 = ready (accessed atomically)
+
+// Builds the tables once. Lists on other threads may be saved or loaded at the same
+// time; the first caller builds and the others wait the few microseconds it takes.
+static void crc32c_init(void)
+{
+    int expected = 0;
+    if (!__atomic_compare_exchange_n(&crc_table_state, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+    {
+        while (__atomic_load_n(&crc_table_state, __ATOMIC_ACQUIRE) != 2)
+        {
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+        {
+            c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+        }
+        crc_table[0][i] = c;
+    }
+    for (int t = 1; t < 8; t++)
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            uint32_t c = crc_table[t - 1][i];
+            crc_table[t][i] = (c >> 8) ^ crc_table[0][c & 0xFF];
+        }
+    }
+    __atomic_store_n(&crc_table_state, 2, __ATOMIC_RELEASE);
+}
+#endif
+
+// Extends crc (0 to start) over len bytes. Uses the SSE4.2 crc32 instruction
+// when the build targets it, otherwise eight table lookups per 8 bytes.
+static uint32_t crc32c(uint32_t crc, const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    crc = ~crc;
+#if defined(__SSE4_2__)
+    uint64_t c = crc;
+    while (len >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        c = _mm_crc32_u64(c, word);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)c;
+    while (len--)
+    {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+#else
+    if (__atomic_load_n(&crc_table_state, __ATOMIC_ACQUIRE) != 2)
+        crc32c_init();
+    while (len >= 8)
+    {
+        uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^
+              crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][p[4]] ^ crc_table[2][p[5]] ^ crc_table[1][p[6]] ^ crc_table[0][p[7]];
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+    {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+    }
+#endif
+    return ~crc;
+}
+
+// --- Checksummed I/O Helpers ---
+
+// Writes data and folds it into the running checksum
+static int put(IoFile *fp, uint32_t *crc, const void *data, size_t len)
+{
+    *crc = crc32c(*crc, data, len);
+    return io_write(fp, data, len);
+}
+
+// Reads data and folds what was read into the running checksum
+static size_t get(IoFile *fp, uint32_t *crc, void *data, size_t len)
+{
+    size_t n = io_read(fp, data, len);
+    *crc = crc32c(*crc, data, n);
+    return n;
+}
+
+// Gives up on a save: the temp file is removed and the real file is left untouched
+static int abandon_save(IoFile *fp, const char *temp, const char *what)
+{
+    perror(what);
+    if (fp)
+        io_close(fp);
+    remove(temp);
+    return 0;
+}
 
 // Saves the skip list data to a binary file
 int save_database(SkipList *list, const char *filename)
+{
+    return save_database_ex(list, filename, NULL);
+}
+
+// Same as save_database, but with an explicit I/O backend. Records are staged into
+// large blocks; each full block is written while the next one is being serialized.
+// The data goes to filename.tmp, is fsynced, and only then renamed over filename,
+// so a crash at any point leaves either the old or the new database intact.
+int save_database_ex(SkipList *list, const char *filename, const IoOptions *io)
 {
     if (!list || !filename)
         return 0;
 
-    FILE *fp = fopen(filename, "wb"); // Open in binary write mode
+    char temp[1024];
+    if (snprintf(temp, sizeof(temp), "%s" TEMP_SUFFIX, filename) >= (int)sizeof(temp))
+    {
+        fprintf(stderr, "Error: database file name too long: %s\n", filename);
+        return 0;
+    }
+
+    IoOptions options;
+    if (io)
+        options = *io;
+    else
+        io_default_options(&options);
+    options.sync = 1; // The rename must not reach the disk before the data does
+
+    IoFile *fp = io_open_write(temp, &options); // Open in binary write mode
     if (!fp)
     {
         perror("Error opening file for saving");
@@ -18,34 +163,64 @@ int save_database(SkipList *list, const char *filename)
 
     SkipListNode *current = list->header->forward[0];
     size_t records_written = 0;
+    uint32_t crc = 0;
 
     // Write the number of records first (optional but helpful for loading)
-    if (fwrite(&list->size, sizeof(size_t), 1, fp) != 1)
-    {
-        perror("Error writing record count");
-        fclose(fp);
-        return 0;
-    }
+    if (!put(fp, &crc, &list->size, sizeof(size_t)))
+        return abandon_save(fp, temp, "Error writing record count");
 
     // Iterate through level 0 (contains all nodes)
     while (current)
     {
-        if (current->value)
+        // Write the entire Record struct directly
+        if (!put(fp, &crc, skiplist_record(list, current), sizeof(Record)))
+            return abandon_save(fp, temp, "Error writing record data");
+        records_written++;
+        current = current->forward[0];
+    }
+
+    if (list->ttl)
+    {
+        // Deadlines follow the records, terminated by an entry with key -1
+        unsigned int magic = TTL_SECTION_MAGIC;
+        TtlEntry entry;
+        memset(&entry, 0, sizeof(entry)); // The padding after key is written and checksummed too
+        int ok = put(fp, &crc, &magic, sizeof(magic));
+        for (current = list->header->forward[0]; current && ok; current = current->forward[0])
         {
-            // Write the entire Record struct directly
-            if (fwrite(current->value, sizeof(Record), 1, fp) != 1)
+            if (current->flags & NODE_HAS_TTL)
             {
-                perror("Error writing record data");
-                // Attempt to close file, but indicate failure
-                fclose(fp);
-                return 0; // Indicate failure, data might be corrupt
+                entry.key = current->key;
+                entry.expires_at = skiplist_deadline(list, current);
+                ok = put(fp, &crc, &entry, sizeof(entry));
             }
-            records_written++;
         }
-        current = current->forward[0];
+        entry.key = -1;
+        entry.expires_at = 0;
+        if (!ok || !put(fp, &crc, &entry, sizeof(entry)))
+            return abandon_save(fp, temp, "Error writing record deadlines");
     }
 
-    fclose(fp);
+    // The trailer covers everything above; the loader rejects the file if it does not match
+    uint32_t trailer[2] = {CRC_TRAILER_MAGIC, crc};
+    if (!io_write(fp, trailer, sizeof(trailer)))
+        return abandon_save(fp, temp, "Error writing checksum");
+
+    const char *backend = io_backend_name(fp);
+    if (!io_close(fp)) // Waits for the writes still in flight, then fsyncs
+        return abandon_save(NULL, temp, "Error writing record data");
+
+    if (rename(temp, filename) != 0)
+    {
+        // Windows will not rename over an existing file. Removing it first is not
+        // atomic, but the complete new copy is already on disk under the temp name.
+        if (remove(filename) != 0 || rename(temp, filename) != 0)
+            return abandon_save(NULL, temp, "Error replacing database file");
+    }
+    if (!io_sync_dir(filename))
+    {
+        perror("Warning: could not sync database directory");
+    }
 
     if (records_written != list->size)
     {
@@ -55,35 +230,55 @@ int save_database(SkipList *list, const char *filename)
         // Decide if this is critical enough to return failure
     }
 
-    printf("Database saved successfully to %s (%lu records).\n", filename, (unsigned long)records_written);
+    printf("Database saved successfully to %s (%lu records, %s).\n", filename, (unsigned long)records_written, backend);
     return 1; // Success
 }
 
 // Loads data from a binary file into a new skip list
 SkipList *load_database(const char *filename)
 {
-    FILE *fp = fopen(filename, "rb"); // Open in binary read mode
+    return load_database_ex(filename, NULL, NULL);
+}
+
+// Frees a list loaded from a damaged file and reports why it was rejected
+static SkipList *reject_file(IoFile *fp, SkipList *list, const char *filename, const char *why)
+{
+    fprintf(stderr, "Error: %s is damaged (%s); it was not loaded.\n", filename, why);
+    io_close(fp);
+    free_skiplist(list);
+    return NULL;
+}
+
+// Same as load_database, but the new list is created with the given options and the
+// file is read through the given I/O backend. Blocks further ahead are already being
+// read while records from the current one are decoded and inserted.
+// Returns NULL if the file is truncated or fails its checksum.
+SkipList *load_database_ex(const char *filename, const SkipListOptions *opts, const IoOptions *io)
+{
+    IoFile *fp = io_open_read(filename, io); // Open in binary read mode
     if (!fp)
     {
         // It's okay if the file doesn't exist on first run
         // perror("Error opening file for loading");
-        return create_skiplist(); // Return a new empty list
+        return create_skiplist_ex(opts); // Return a new empty list
     }
 
-    SkipList *list = create_skiplist();
+    SkipList *list = create_skiplist_ex(opts);
     if (!list)
     {
-        fclose(fp);
+        io_close(fp);
         return NULL; // Failed to create list structure
     }
 
     size_t record_count = 0;
     size_t records_read = 0;
+    uint32_t crc = 0;
 
     // Read the number of records (if saved)
-    if (fread(&record_count, sizeof(size_t), 1, fp) != 1)
+    size_t got = get(fp, &crc, &record_count, sizeof(size_t));
+    if (got != sizeof(size_t))
     {
-        if (!feof(fp))
+        if (got != 0 || io_error(fp))
         { // Don't report error if file was just empty
             perror("Error reading record count");
         }
@@ -91,26 +286,29 @@ SkipList *load_database(const char *filename)
         // Or return list here if count is critical
     }
 
+    // Optional sections may follow the records, so stop after record_count of them
+    size_t records_left = (got == sizeof(size_t)) ? record_count : (size_t)-1;
+
     Record temp_record;
     // Read records one by one
-    while (fread(&temp_record, sizeof(Record), 1, fp) == 1)
+    while (records_left > 0 && get(fp, &crc, &temp_record, sizeof(Record)) == sizeof(Record))
     {
-        // Create a new Record on the heap to store in the list
-        Record *new_rec = (Record *)malloc(sizeof(Record));
+        records_left--;
+        // Create a new Record (from the list's arena, if any) to store in the list
+        Record *new_rec = create_record_in(list->arena, temp_record.id, temp_record.name, temp_record.value);
         if (!new_rec)
         {
-            perror("Memory allocation failed during load");
+            // create_record_in already reported the error
             // Cleanup partially loaded list? Difficult. Best effort: return what we have.
-            fclose(fp);
+            io_close(fp);
             return list; // Return partially loaded list
         }
-        *new_rec = temp_record; // Copy data
 
         // Insert into the skip list
         if (!insert_skiplist(list, new_rec->id, new_rec))
         {
             fprintf(stderr, "Error inserting record ID %d during load (duplicate? memory?)\n", new_rec->id);
-            free(new_rec); // Free the record we couldn't insert
+            free_record_in(list->arena, new_rec); // Free the record we couldn't insert
             // Continue loading others?
         }
         else
@@ -118,15 +316,51 @@ SkipList *load_database(const char *filename)
             records_read++;
         }
     }
+    if (got == sizeof(size_t) && records_left > 0)
+        return reject_file(fp, list, filename, "truncated");
 
-    if (ferror(fp))
+    // Sections after the records, ending with the checksum trailer. Files saved
+    // before checksums were added simply end here.
+    int verified = 0;
+    unsigned int magic = 0;
+    uint32_t crc_before = crc;
+    while (!verified && get(fp, &crc, &magic, sizeof(magic)) == sizeof(magic))
+    {
+        if (magic == TTL_SECTION_MAGIC)
+        {
+            TtlEntry entry;
+            while (get(fp, &crc, &entry, sizeof(entry)) == sizeof(entry) && entry.key >= 0)
+            {
+                skiplist_expire_at(list, entry.key, entry.expires_at); // Records that expired meanwhile are dropped
+            }
+        }
+        else if (magic == CRC_TRAILER_MAGIC)
+        {
+            uint32_t stored = 0;
+            if (io_read(fp, &stored, sizeof(stored)) != sizeof(stored) || stored != crc_before)
+                return reject_file(fp, list, filename, "checksum mismatch");
+            verified = 1;
+        }
+        else
+        {
+            return reject_file(fp, list, filename, "unknown section");
+        }
+        crc_before = crc;
+    }
+
+    if (io_error(fp))
     {
         perror("Error reading from database file");
         // Keep partially loaded list? Or free and return NULL?
         // Let's return what we managed to load.
     }
+    else if (!verified && got == sizeof(size_t))
+    {
+        fprintf(stderr, "Warning: %s has no checksum (saved by an older version).\n", filename);
+    }
 
-    fclose(fp);
-    printf("Database loaded successfully from %s (%lu records read).\n", filename, (unsigned long)records_read);
+    io_close(fp);
+    printf("Database loaded successfully from %s (%lu records read%s).\n", filename, (unsigned long)records_read,
+           verified ? ", checksum ok" : "");
     return list;
-}
\ No newline at end of file
+}
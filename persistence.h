@@ -2,8 +2,14 @@
 #define PERSISTENCE_H
 
 #include "skiplist.h"
+#include "iobackend.h"
 
+// Saves go to a temp file that is fsynced and renamed over filename, so a crash never
+// leaves a partial database. Loads return NULL if the file fails its checksum.
 int save_database(SkipList *list, const char *filename);
 SkipList *load_database(const char *filename);
+// NULL opts/io = defaults
+int save_database_ex(SkipList *list, const char *filename, const IoOptions *io);
+SkipList *load_database_ex(const char *filename, const SkipListOptions *opts, const IoOptions *io);
 
 #endif // PERSISTENCE_H
\ No newline at end of file
@@ -5,7 +5,12 @@
 
 Record *create_record(int id, const char *name, double value)
 {
-    Record *rec = (Record *)malloc(sizeof(Record));
+    return create_record_in(NULL, id, name, value);
+}
+
+Record *create_record_in(Arena *arena, int id, const char *name, double value)
+{
+    Record *rec = (Record *)arena_alloc(arena, sizeof(Record));
     if (!rec)
     {
         perror("Failed to allocate memory for record");
@@ -18,6 +23,11 @@ Record *create_record(int id, const char *name, double value)
     return rec;
 }
 
+void free_record_in(Arena *arena, Record *record)
+{
+    arena_free(arena, record, sizeof(Record));
+}
+
 void print_record(const Record *record)
 {
     if (record)
@@ -32,4 +42,4 @@ void print_record(const Record *record)
     }
 }
 
-// No free_record needed here as it's handled by skiplist delete/free
\ No newline at end of file
+// Records inserted into a skip list are freed by delete_skiplist/free_skiplist
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef RECORD_H
 #define RECORD_H
 
+#include "arena.h"
+
 #define MAX_NAME_LEN 64
 
 // Structure to hold the actual data
@@ -14,7 +16,10 @@ typedef struct
 
 // Function prototypes for record handling (optional but good practice)
 Record *create_record(int id, const char *name, double value);
+// Same as create_record, but allocates from an arena (NULL arena = malloc)
+Record *create_record_in(Arena *arena, int id, const char *name, double value);
+void free_record_in(Arena *arena, Record *record);
 void print_record(const Record *record);
-// Note: free_record is implicitly handled when deleting from skiplist
+// Note: records owned by a skiplist are freed when deleted from it
 
 #endif // RECORD_H
\ No newline at end of file
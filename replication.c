@@ -0,0 +1,505 @@
+#include "replication.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define REPL_HAVE_SOCKETS 1
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // A follower that went away must not kill the leader with SIGPIPE
+#endif
+
+// --- Helper Functions ---
+
+static int64_t wall_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static Replicator *repl_alloc(ReplRole role, const char *path)
+{
+    if (strlen(path) >= sizeof(((Replicator *)0)->path))
+    {
+        fprintf(stderr, "Error: replication socket path too long: %s\n", path);
+        return NULL;
+    }
+
+    Replicator *repl = (Replicator *)calloc(1, sizeof(Replicator));
+    if (!repl)
+        return NULL;
+    repl->role = role;
+    strcpy(repl->path, path);
+    repl->listen_fd = -1;
+    repl->fd = -1;
+    for (int i = 0; i < REPL_MAX_FOLLOWERS; i++)
+    {
+        repl->followers[i] = -1;
+    }
+    return repl;
+}
+
+static void fill_frame(ReplFrame *frame, uint64_t seq, ReplOpKind op, const Record *record, time_t expires_at)
+{
+    memset(frame, 0, sizeof(*frame));
+    frame->seq = seq;
+    frame->sent_ns = wall_clock_ns();
+    frame->op = (int32_t)op;
+    frame->expires_at = (int64_t)expires_at;
+    if (record)
+        frame->record = *record;
+}
+
+#ifdef REPL_HAVE_SOCKETS
+static void fill_address(struct sockaddr_un *addr, const char *path)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    memcpy(addr->sun_path, path, strlen(path) + 1); // Length checked against Replicator.path
+}
+
+// Writes all of data to a follower. Returns 0 if the follower is gone.
+// Removes path if it is a socket file, such as one left behind by an earlier leader.
+// Returns 0, removing nothing, if something other than a socket is there.
+static int remove_socket_file(const char *path)
+{
+    struct stat st;
+    if (lstat(path, &st) != 0)
+        return 1; // Nothing there
+    if (!S_ISSOCK(st.st_mode))
+        return 0;
+    unlink(path);
+    return 1;
+}
+
+static int send_fully(int fd, const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+    while (len > 0)
+    {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static void drop_follower(Replicator *repl, int slot)
+{
+    close(repl->followers[slot]);
+    repl->followers[slot] = -1;
+    repl->dropped++;
+    fprintf(stderr, "Warning: replication follower disconnected.\n");
+}
+
+// Sends frames to one follower; drops it on failure
+static int send_frames(Replicator *repl, int slot, const ReplFrame *frames, size_t count)
+{
+    if (!send_fully(repl->followers[slot], frames, count * sizeof(ReplFrame)))
+    {
+        drop_follower(repl, slot);
+        return 0;
+    }
+    repl->bytes += count * sizeof(ReplFrame);
+    return 1;
+}
+
+// Streams the current list to one follower, in key order so it appends at the tail
+static void send_snapshot(Replicator *repl, int slot, SkipList *list)
+{
+    ReplFrame chunk[REPL_SNAPSHOT_CHUNK];
+    size_t n = 0;
+    time_t now = time(NULL);
+
+    fill_frame(&chunk[n++], repl->seq, REPL_OP_SNAPSHOT_BEGIN, NULL, 0);
+    for (SkipListNode *node = list->header->forward[0]; node; node = node->forward[0])
+    {
+        time_t expires_at = skiplist_deadline(list, node);
+        if (expires_at != 0 && expires_at <= now)
+            continue; // Expired, just not reclaimed yet
+        fill_frame(&chunk[n++], repl->seq, REPL_OP_ADD, skiplist_record(list, node), expires_at);
+        if (n == REPL_SNAPSHOT_CHUNK)
+        {
+            if (!send_frames(repl, slot, chunk, n))
+                return;
+            n = 0;
+        }
+    }
+    fill_frame(&chunk[n++], repl->seq, REPL_OP_SNAPSHOT_END, NULL, 0);
+    if (send_frames(repl, slot, chunk, n))
+        repl->snapshots++;
+}
+
+// Leader: takes every pending connection and brings it up to date
+static void accept_followers(Replicator *repl, SkipList *list)
+{
+    while (1)
+    {
+        int fd = accept(repl->listen_fd, NULL, NULL);
+        if (fd < 0)
+            return; // EAGAIN: no more pending connections
+
+        int slot = -1;
+        for (int i = 0; i < REPL_MAX_FOLLOWERS && slot < 0; i++)
+        {
+            if (repl->followers[i] < 0)
+                slot = i;
+        }
+        if (slot < 0)
+        {
+            fprintf(stderr, "Warning: too many replication followers, refusing one.\n");
+            close(fd);
+            continue;
+        }
+
+        // Accepted sockets are blocking: a follower that falls behind slows the
+        // leader down instead of silently missing changes
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        repl->followers[slot] = fd;
+        send_snapshot(repl, slot, list);
+    }
+}
+
+static int connect_leader(Replicator *repl)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return 0;
+
+    struct sockaddr_un addr;
+    fill_address(&addr, repl->path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return 0;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    repl->fd = fd;
+    repl->inbuf_len = 0;
+    repl->synced = 0;
+    return 1;
+}
+
+// Follower: applies one change from the leader
+static void apply_frame(Replicator *repl, const ReplFrame *frame, SkipList **list, const SkipListOptions *opts)
+{
+    const Record *rec = &frame->record;
+    switch (frame->op)
+    {
+    case REPL_OP_SNAPSHOT_BEGIN:
+    {
+        SkipList *fresh = create_skiplist_ex(opts);
+        if (!fresh)
+        {
+            fprintf(stderr, "Error: could not allocate a list for the leader's snapshot.\n");
+            return;
+        }
+        free_skiplist(*list);
+        *list = fresh;
+        repl->synced = 0;
+        break;
+    }
+    case REPL_OP_SNAPSHOT_END:
+        repl->synced = 1;
+        repl->snapshots++;
+        break;
+    case REPL_OP_ADD:
+    {
+        Record *copy = create_record_in((*list)->arena, rec->id, rec->name, rec->value);
+        if (copy && !insert_skiplist(*list, rec->id, copy))
+        {
+            // Already present (e.g. queued before our snapshot was taken): take the leader's version
+            free_record_in((*list)->arena, copy);
+            update_skiplist(*list, rec->id, rec->name, rec->value);
+        }
+        if (frame->expires_at != 0)
+            skiplist_expire_at(*list, rec->id, (time_t)frame->expires_at);
+        break;
+    }
+    case REPL_OP_UPDATE:
+        update_skiplist(*list, rec->id, rec->name, rec->value);
+        break;
+    case REPL_OP_DEL:
+        delete_skiplist(*list, rec->id);
+        break;
+    case REPL_OP_EXPIRE:
+        skiplist_expire_at(*list, rec->id, (time_t)frame->expires_at);
+        break;
+    default:
+        fprintf(stderr, "Warning: unknown replication op %d ignored.\n", (int)frame->op);
+        return;
+    }
+
+    repl->seq = frame->seq;
+    repl->frames++;
+    if (frame->op != REPL_OP_SNAPSHOT_BEGIN && frame->op != REPL_OP_SNAPSHOT_END)
+    {
+        double lag = (double)(wall_clock_ns() - frame->sent_ns) / 1e6;
+        repl->last_lag_ms = lag;
+        if (lag > repl->max_lag_ms)
+            repl->max_lag_ms = lag;
+    }
+}
+
+// Follower: reads whatever has arrived and applies every complete frame, a batch at a time
+static void receive_frames(Replicator *repl, SkipList **list, const SkipListOptions *opts)
+{
+    const size_t cap = REPL_BATCH_FRAMES * sizeof(ReplFrame);
+    while (1)
+    {
+        ssize_t n = read(repl->fd, repl->inbuf + repl->inbuf_len, cap - repl->inbuf_len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return; // Drained
+        if (n <= 0)
+        {
+            fprintf(stderr, "Warning: lost connection to replication leader, serving stale data.\n");
+            close(repl->fd);
+            repl->fd = -1;
+            return;
+        }
+        repl->bytes += (size_t)n;
+        repl->inbuf_len += (size_t)n;
+
+        size_t whole = repl->inbuf_len / sizeof(ReplFrame);
+        for (size_t i = 0; i < whole; i++)
+        {
+            ReplFrame frame;
+            memcpy(&frame, repl->inbuf + i * sizeof(ReplFrame), sizeof(frame));
+            apply_frame(repl, &frame, list, opts);
+        }
+        // Keep the partial frame at the end for the next read
+        size_t used = whole * sizeof(ReplFrame);
+        memmove(repl->inbuf, repl->inbuf + used, repl->inbuf_len - used);
+        repl->inbuf_len -= used;
+    }
+}
+#endif
+
+// --- Public API ---
+
+Replicator *repl_leader_create(const char *path)
+{
+#ifdef REPL_HAVE_SOCKETS
+    Replicator *repl = repl_alloc(REPL_LEADER, path);
+    if (!repl)
+        return NULL;
+
+    if (!remove_socket_file(path))
+    {
+        fprintf(stderr, "Error: replication path %s exists and is not a socket.\n", path);
+        free(repl);
+        return NULL;
+    }
+
+    struct sockaddr_un addr;
+    fill_address(&addr, path);
+    repl->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (repl->listen_fd < 0 ||
+        bind(repl->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(repl->listen_fd, REPL_MAX_FOLLOWERS) != 0)
+    {
+        perror("Error creating replication socket");
+        if (repl->listen_fd >= 0)
+            close(repl->listen_fd);
+        free(repl);
+        return NULL;
+    }
+    fcntl(repl->listen_fd, F_SETFL, fcntl(repl->listen_fd, F_GETFL) | O_NONBLOCK);
+    return repl;
+#else
+    (void)path;
+    fprintf(stderr, "Error: replication needs Unix domain sockets.\n");
+    return NULL;
+#endif
+}
+
+Replicator *repl_follower_create(const char *path)
+{
+#ifdef REPL_HAVE_SOCKETS
+    Replicator *repl = repl_alloc(REPL_FOLLOWER, path);
+    if (!repl)
+        return NULL;
+    repl->inbuf = (char *)malloc(REPL_BATCH_FRAMES * sizeof(ReplFrame));
+    if (!repl->inbuf || !connect_leader(repl))
+    {
+        perror("Error connecting to replication leader");
+        free(repl->inbuf);
+        free(repl);
+        return NULL;
+    }
+    return repl;
+#else
+    (void)path;
+    fprintf(stderr, "Error: replication needs Unix domain sockets.\n");
+    return NULL;
+#endif
+}
+
+void repl_destroy(Replicator *repl)
+{
+    if (!repl)
+        return;
+#ifdef REPL_HAVE_SOCKETS
+    repl_flush(repl);
+    for (int i = 0; i < REPL_MAX_FOLLOWERS; i++)
+    {
+        if (repl->followers[i] >= 0)
+            close(repl->followers[i]);
+    }
+    if (repl->listen_fd >= 0)
+    {
+        close(repl->listen_fd);
+        remove_socket_file(repl->path); // Unless something else has taken its place
+    }
+    if (repl->fd >= 0)
+        close(repl->fd);
+#endif
+    free(repl->pending);
+    free(repl->inbuf);
+    free(repl);
+}
+
+void repl_publish(Replicator *repl, ReplOpKind op, const Record *record, time_t expires_at)
+{
+    if (!repl || repl->role != REPL_LEADER)
+        return;
+    repl->seq++;
+
+    int any = 0;
+    for (int i = 0; i < REPL_MAX_FOLLOWERS; i++)
+    {
+        any |= repl->followers[i] >= 0;
+    }
+    if (!any)
+        return; // Nobody to send to; a later follower starts from a snapshot
+
+    if (repl->pending_count == repl->pending_cap)
+    {
+        size_t cap = repl->pending_cap ? repl->pending_cap * 2 : REPL_SNAPSHOT_CHUNK;
+        ReplFrame *frames = (ReplFrame *)realloc(repl->pending, cap * sizeof(ReplFrame));
+        if (!frames)
+        {
+            // Followers would silently diverge; cut them off so they resync on reconnect
+            fprintf(stderr, "Error: replication queue full, disconnecting followers.\n");
+#ifdef REPL_HAVE_SOCKETS
+            for (int i = 0; i < REPL_MAX_FOLLOWERS; i++)
+            {
+                if (repl->followers[i] >= 0)
+                    drop_follower(repl, i);
+            }
+#endif
+            repl->pending_count = 0;
+            return;
+        }
+        repl->pending = frames;
+        repl->pending_cap = cap;
+    }
+    fill_frame(&repl->pending[repl->pending_count++], repl->seq, op, record, expires_at);
+}
+
+void repl_flush(Replicator *repl)
+{
+    if (!repl || repl->pending_count == 0)
+        return;
+#ifdef REPL_HAVE_SOCKETS
+    for (int i = 0; i < REPL_MAX_FOLLOWERS; i++)
+    {
+        if (repl->followers[i] >= 0)
+            send_frames(repl, i, repl->pending, repl->pending_count);
+    }
+#endif
+    repl->frames += repl->pending_count;
+    repl->pending_count = 0;
+}
+
+void repl_snapshot_all(Replicator *repl, SkipList *list)
+{
+    if (!repl || repl->role != REPL_LEADER)
+        return;
+    repl->pending_count = 0; // Superseded by the snapshot
+#ifdef REPL_HAVE_SOCKETS
+    for (int i = 0; i < REPL_MAX_FOLLOWERS; i++)
+    {
+        if (repl->followers[i] >= 0)
+            send_snapshot(repl, i, list);
+    }
+#else
+    (void)list;
+#endif
+}
+
+int repl_poll_fd(const Replicator *repl)
+{
+    if (!repl)
+        return -1;
+    return repl->role == REPL_LEADER ? repl->listen_fd : repl->fd;
+}
+
+int repl_poll_timeout(const Replicator *repl)
+{
+    // A disconnected follower wakes up periodically to retry
+    return (repl && repl->role == REPL_FOLLOWER && repl->fd < 0) ? REPL_RETRY_MS : -1;
+}
+
+void repl_service(Replicator *repl, SkipList **list, const SkipListOptions *opts)
+{
+    if (!repl)
+        return;
+#ifdef REPL_HAVE_SOCKETS
+    if (repl->role == REPL_LEADER)
+    {
+        repl_flush(repl); // Existing followers must not see changes twice
+        accept_followers(repl, *list);
+    }
+    else
+    {
+        if (repl->fd < 0 && !connect_leader(repl))
+            return;
+        receive_frames(repl, list, opts);
+    }
+#else
+    (void)list;
+    (void)opts;
+#endif
+}
+
+void print_repl_stats(const Replicator *repl)
+{
+    if (repl->role == REPL_LEADER)
+    {
+        int connected = 0;
+        for (int i = 0; i < REPL_MAX_FOLLOWERS; i++)
+        {
+            connected += repl->followers[i] >= 0;
+        }
+        printf("  Replication: leader on %s, %d followers, %lu dropped\n",
+               repl->path, connected, (unsigned long)repl->dropped);
+        printf("  Replication Stream: seq %llu, %lu frames (%lu bytes) sent, %lu snapshots\n",
+               (unsigned long long)repl->seq, (unsigned long)repl->frames,
+               (unsigned long)repl->bytes, (unsigned long)repl->snapshots);
+    }
+    else
+    {
+        printf("  Replication: follower of %s (%s)\n", repl->path,
+               repl->fd < 0 ? "disconnected" : (repl->synced ? "in sync" : "receiving snapshot"));
+        printf("  Replication Stream: applied seq %llu, %lu frames (%lu bytes), %lu snapshots\n",
+               (unsigned long long)repl->seq, (unsigned long)repl->frames,
+               (unsigned long)repl->bytes, (unsigned long)repl->snapshots);
+        printf("  Replication Lag: %.3f ms latest, %.3f ms max\n", repl->last_lag_ms, repl->max_lag_ms);
+    }
+}
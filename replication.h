@@ -0,0 +1,92 @@
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include "skiplist.h"
+#include "record.h"
+#include <stddef.h> // size_t
+#include <stdint.h>
+#include <time.h>   // time_t
+
+// --- Tunable Parameters ---
+// Followers a leader streams to at once
+#define REPL_MAX_FOLLOWERS 8
+// Frames a follower reads (and applies) per batch
+#define REPL_BATCH_FRAMES 256
+// Frames per write while sending a snapshot
+#define REPL_SNAPSHOT_CHUNK 256
+// How often a disconnected follower retries its leader (milliseconds)
+#define REPL_RETRY_MS 1000
+// -------------------------
+
+typedef enum
+{
+    REPL_NONE = 0,
+    REPL_LEADER,  // Publishes every change to connected followers
+    REPL_FOLLOWER // Applies the leader's changes and serves reads
+} ReplRole;
+
+typedef enum
+{
+    REPL_OP_ADD = 1,
+    REPL_OP_UPDATE,
+    REPL_OP_DEL,
+    REPL_OP_EXPIRE,
+    REPL_OP_SNAPSHOT_BEGIN, // Follower drops its data; the ADDs that follow are the leader's state
+    REPL_OP_SNAPSHOT_END
+} ReplOpKind;
+
+// One change on the wire. Leader and follower run on the same host, so the
+// frame is sent as-is, like records in the database file.
+typedef struct
+{
+    uint64_t seq;       // Leader's sequence number of the change
+    int64_t sent_ns;    // Leader's wall clock when the change was made
+    int32_t op;         // ReplOpKind
+    int32_t pad;
+    int64_t expires_at; // ADD and EXPIRE: deadline (0 = none)
+    Record record;      // ADD/UPDATE: full record; DEL/EXPIRE: only id is used
+} ReplFrame;
+
+typedef struct
+{
+    ReplRole role;
+    char path[108];                    // Unix socket path
+    int listen_fd;                     // Leader: socket followers connect to
+    int followers[REPL_MAX_FOLLOWERS]; // Leader: connected followers (-1 = free)
+    ReplFrame *pending;                // Leader: frames not yet sent
+    size_t pending_count;
+    size_t pending_cap;
+    int fd;                            // Follower: connection to the leader (-1 = disconnected)
+    char *inbuf;                       // Follower: received bytes not yet applied
+    size_t inbuf_len;
+    int synced;                        // Follower: a full snapshot has been applied
+    uint64_t seq;                      // Leader: last change published; follower: last applied
+    size_t frames;                     // Frames sent (leader) or applied (follower)
+    size_t bytes;                      // Bytes sent or received
+    size_t snapshots;                  // Snapshots sent or applied
+    size_t dropped;                    // Leader: followers dropped after a failed send
+    double last_lag_ms;                // Follower: leader-to-apply delay of the latest change
+    double max_lag_ms;                 // Follower: worst delay seen
+} Replicator;
+
+// Leader: listens on path (replacing a stale socket file). NULL on failure.
+Replicator *repl_leader_create(const char *path);
+// Follower: connects to a leader listening on path. NULL on failure.
+Replicator *repl_follower_create(const char *path);
+void repl_destroy(Replicator *repl);
+
+// Queues a change; repl_flush sends everything queued to every follower
+void repl_publish(Replicator *repl, ReplOpKind op, const Record *record, time_t expires_at);
+void repl_flush(Replicator *repl);
+// Leader: sends the whole list to every follower (after the list was replaced)
+void repl_snapshot_all(Replicator *repl, SkipList *list);
+
+// Descriptor to poll for input (-1 = none) and the poll timeout to use (-1 = infinite)
+int repl_poll_fd(const Replicator *repl);
+int repl_poll_timeout(const Replicator *repl);
+// Non-blocking: the leader accepts followers and sends them a snapshot; the follower
+// applies every complete frame received. *list may be replaced by a snapshot.
+void repl_service(Replicator *repl, SkipList **list, const SkipListOptions *opts);
+void print_repl_stats(const Replicator *repl);
+
+#endif // REPLICATION_H
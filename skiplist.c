@@ -2,24 +2,25 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h> // Malloc, free
-#include <time.h>   // For seeding random number generator
+#include <time.h>   // time(), for expiry
+#ifdef __GLIBC__
+#include <malloc.h> // malloc_usable_size
+#endif
 
 // --- Helper Functions ---
 
-// Creates a new skip list node
-static SkipListNode *create_node(int level, int key, Record *value)
+// Bytes needed for a node with the given level (forward pointers are inline)
+static size_t node_size(int level)
 {
-    SkipListNode *node = (SkipListNode *)malloc(sizeof(SkipListNode));
-    if (!node)
-        return NULL;
+    return sizeof(SkipListNode) + sizeof(SkipListNode *) * (level + 1);
+}
 
-    // Allocate space for the forward pointers array (level + 1 pointers)
-    node->forward = (SkipListNode **)malloc(sizeof(SkipListNode *) * (level + 1));
-    if (!node->forward)
-    {
-        free(node);
+// Creates a new skip list node of the given size, taking memory from the arena if one is given
+static SkipListNode *create_node(Arena *arena, size_t bytes, int level, int key)
+{
+    SkipListNode *node = (SkipListNode *)arena_alloc(arena, bytes);
+    if (!node)
         return NULL;
-    }
 
     // Initialize forward pointers to NULL
     for (int i = 0; i <= level; i++)
@@ -28,147 +29,620 @@ static SkipListNode *create_node(int level, int key, Record *value)
     }
 
     node->key = key;
-    node->value = value; // Stores the pointer to the actual record
-    node->level = level;
+    node->level = (int16_t)level;
+    node->flags = 0;
+
+    return node;
+}
+
+// Bytes taken by a data node of this list. After the forward pointers comes the
+// record itself in compact mode, or a pointer to it.
+static size_t data_node_size(const SkipList *list, int level)
+{
+    return node_size(level) + (list->compact ? sizeof(Record) : sizeof(Record *));
+}
+
+// The record pointer of a node outside compact mode
+static Record **record_slot(SkipListNode *node)
+{
+    return (Record **)&node->forward[node->level + 1];
+}
 
+Record *skiplist_record(const SkipList *list, const SkipListNode *node)
+{
+    Record *const *slot = (Record *const *)&node->forward[node->level + 1];
+    return list->compact ? (Record *)slot : *slot;
+}
+
+time_t skiplist_deadline(const SkipList *list, const SkipListNode *node)
+{
+    return (node->flags & NODE_HAS_TTL) ? ttl_wheel_deadline(list->ttl, node->key) : 0;
+}
+
+// Creates a node for a record of this list. In compact mode the record is copied
+// in after the forward pointers; the caller still owns (and frees) the original.
+static SkipListNode *create_data_node(SkipList *list, int level, int key, Record *value)
+{
+    SkipListNode *node = create_node(list->arena, data_node_size(list, level), level, key);
+    if (node && list->compact)
+        *skiplist_record(list, node) = *value;
+    else if (node)
+        *record_slot(node) = value;
     return node;
 }
 
+// Frees a node and the record it owns. Its deadline, if any, is the caller's to clear.
+static void release_node(SkipList *list, SkipListNode *node)
+{
+    if (!list->compact && *record_slot(node))
+    {
+        free_record_in(list->arena, *record_slot(node));
+    }
+    arena_free(list->arena, node, data_node_size(list, node->level));
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void)(addr))
+#endif
+
+// True once a node's TTL has run out
+static int is_expired(const SkipList *list, const SkipListNode *node, time_t now)
+{
+    time_t when = skiplist_deadline(list, node);
+    return when != 0 && when <= now;
+}
+
+// Gives node a deadline: queues it on the wheel and records it in the wheel's table.
+// Returns 0 on allocation failure, with the deadline node had (if any) unchanged.
+static int set_deadline(SkipList *list, SkipListNode *node, time_t when, time_t now)
+{
+    if (!list->ttl && !(list->ttl = ttl_wheel_create(now)))
+        return 0;
+    // A wheel entry left over from a failed table update is stale and dropped when reached
+    if (!ttl_wheel_add(list->ttl, node->key, when) || !ttl_wheel_set_deadline(list->ttl, node->key, when))
+        return 0;
+    node->flags |= NODE_HAS_TTL;
+    return 1;
+}
+
+// Drops node's deadline; its wheel entry goes stale and is dropped when reached
+static void clear_deadline(SkipList *list, SkipListNode *node)
+{
+    if (node->flags & NODE_HAS_TTL)
+    {
+        ttl_wheel_clear_deadline(list->ttl, node->key);
+        node->flags &= (uint16_t)~NODE_HAS_TTL;
+    }
+}
+
+// Next number from the list's own generator, so lists (and threads) do not share rand()
+// and a seeded list always builds the same towers
+static uint32_t next_random(SkipList *list)
+{
+    uint32_t x = list->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return list->rng = x;
+}
+
 // Generates a random level for a new node
 // Levels are 0-based
-static int random_level()
+static int random_level(SkipList *list)
 {
     int level = 0;
-    // RAND_MAX is defined in stdlib.h
-    // Keep increasing level with probability SKIPLIST_P
-    // Ensure level does not exceed MAX_LEVEL - 1
-    while ((rand() < SKIPLIST_P * RAND_MAX) && level < (MAX_LEVEL - 1))
+    // Keep increasing level with probability list->p
+    // Ensure level does not exceed the list's current cap
+    while ((next_random(list) < list->p * 4294967296.0) && level < (list->max_level - 1))
     {
         level++;
     }
     return level;
 }
 
-// --- Core Skip List Operations ---
+// Raises the level cap until it suits a list of `size` nodes and admits towers up to
+// `level`. Must run before a descent: the header may move when it grows.
+static int grow_level_cap(SkipList *list, size_t size, int level)
+{
+    while (((double)size >= list->grow_at || level >= list->max_level) && list->max_level < MAX_LEVEL)
+    {
+        SkipListNode *header = (SkipListNode *)realloc(list->header, node_size(list->max_level));
+        if (!header)
+            return 0;
 
-SkipList *create_skiplist()
+        header->forward[list->max_level] = NULL;
+        header->level = list->max_level;
+        list->header = header;
+        list->max_level++;
+        list->grow_at /= list->p;
+    }
+    return 1;
+}
+
+// Replaces the membership filter with a larger one holding every key in the list.
+// If that fails the filter is dropped rather than left with missing keys.
+static void rebuild_filter(SkipList *list)
 {
-    SkipList *list = (SkipList *)malloc(sizeof(SkipList));
-    if (!list)
-        return NULL;
+    CuckooFilter *old = list->filter;
+    // Twice the old capacity, measured at the load the filter grows at
+    size_t target = (size_t)((double)cuckoo_slots(old) * 2 * CUCKOO_MAX_LOAD);
 
-    // Create header node with minimum key value (or sentinel) and max level
-    // Key = -1 assumes IDs are non-negative. Adjust if necessary.
-    list->header = create_node(MAX_LEVEL - 1, -1, NULL); // Max level index
-    if (!list->header)
+    while (1)
     {
-        free(list);
-        return NULL;
+        CuckooFilter *filter = cuckoo_create(target);
+        if (!filter)
+        {
+            fprintf(stderr, "Warning: could not grow membership filter, disabling it.\n");
+            cuckoo_destroy(old);
+            list->filter = NULL;
+            return;
+        }
+
+        int complete = 1;
+        for (SkipListNode *node = list->header->forward[0]; node; node = node->forward[0])
+        {
+            if (!cuckoo_insert(filter, node->key))
+            {
+                complete = 0;
+                break;
+            }
+        }
+        if (complete)
+        {
+            filter->negatives = old->negatives;
+            filter->false_positives = old->false_positives;
+            cuckoo_destroy(old);
+            list->filter = filter;
+            return;
+        }
+        cuckoo_destroy(filter);
+        target *= 2;
     }
+}
 
-    list->level = 0; // Initially, list level is 0
+// Frees the header and every optional component (any of them may be NULL)
+static void free_components(SkipList *list)
+{
+    free(list->header);
+    cache_destroy(list->cache);
+    cuckoo_destroy(list->filter);
+    column_destroy(list->column);
+    ttl_wheel_destroy(list->ttl);
+    arena_destroy(list->arena);
+}
+
+// --- Relinking ---
+// Set operations rebuild a list in one pass over level 0: nodes are appended in key
+// order and each keeps its own tower height, so no descent or coin flip is needed.
+
+// Starts an empty chain; last[] holds the last node per level (the header for now)
+static void begin_relink(SkipList *list, SkipListNode **last)
+{
+    for (int i = 0; i < list->max_level; i++)
+    {
+        last[i] = list->header;
+    }
+    memset(list->level_counts, 0, sizeof(list->level_counts));
     list->size = 0;
+}
 
-    // Seed random number generator once during initialization
-    srand((unsigned int)time(NULL));
+// Links node after every other node. Only last[] nodes are written, so the caller
+// may still be walking the old chain from nodes not appended yet.
+static void append_node(SkipList *list, SkipListNode **last, SkipListNode *node)
+{
+    for (int i = 0; i <= node->level; i++)
+    {
+        last[i]->forward[i] = node;
+        last[i] = node;
+    }
+    list->level_counts[node->level]++;
+    list->size++;
+}
 
-    return list;
+// Terminates every level and resets the list height and the tail finger
+static void finish_relink(SkipList *list, SkipListNode **last)
+{
+    list->level = 0;
+    for (int i = 0; i < list->max_level; i++)
+    {
+        last[i]->forward[i] = NULL;
+        list->tail[i] = (last[i] == list->header) ? NULL : last[i];
+        if (list->header->forward[i])
+            list->level = i;
+    }
 }
 
-Record *search_skiplist(SkipList *list, int search_key)
+// Rebuilds the cache, filter and column after the list was relinked wholesale
+static void refresh_components(SkipList *list)
 {
-    if (!list)
+    if (list->cache)
+        cache_clear(list->cache); // Dropped nodes may still be cached
+
+    if (list->filter)
+    {
+        CuckooFilter *old = list->filter;
+        list->filter = cuckoo_create(list->size);
+        if (!list->filter)
+        {
+            fprintf(stderr, "Warning: could not rebuild membership filter, disabling it.\n");
+        }
+        else
+        {
+            list->filter->negatives = old->negatives;
+            list->filter->false_positives = old->false_positives;
+            int complete = 1;
+            for (SkipListNode *node = list->header->forward[0]; node && complete; node = node->forward[0])
+            {
+                complete = cuckoo_insert(list->filter, node->key);
+            }
+            if (!complete || cuckoo_needs_growth(list->filter))
+                rebuild_filter(list);
+        }
+        cuckoo_destroy(old);
+    }
+
+    if (list->column)
+    {
+        column_destroy(list->column);
+        list->column = column_create();
+        for (SkipListNode *node = list->header->forward[0]; node && list->column; node = node->forward[0])
+        {
+            if (!column_insert(list->column, node->key, skiplist_record(list, node)->value)) // Appends, so this is linear
+            {
+                column_destroy(list->column);
+                list->column = NULL;
+            }
+        }
+        if (!list->column)
+            fprintf(stderr, "Warning: could not rebuild value column, disabling it.\n");
+    }
+}
+
+// Returns a node of dest for a node of src: the node itself when both lists allocate
+// from the same place (malloc, or an arena shared since a split) and lay out nodes the
+// same way, otherwise a copy (the caller frees the original). NULL if the copy failed.
+static SkipListNode *adopt_node(SkipList *dest, SkipList *src, SkipListNode *node)
+{
+    if (dest->arena == src->arena && dest->compact == src->compact)
+        return node;
+
+    Record *rec = skiplist_record(src, node);
+    if (!dest->compact && !(rec = create_record_in(dest->arena, rec->id, rec->name, rec->value)))
         return NULL;
-    SkipListNode *current = list->header;
+    SkipListNode *copy = create_data_node(dest, node->level, node->key, rec);
+    if (!copy)
+    {
+        if (!dest->compact)
+            free_record_in(dest->arena, rec);
+        return NULL;
+    }
+    return copy; // Without a deadline: src's table is not dest's
+}
 
-    // Start from the highest level of the list
-    for (int i = list->level; i >= 0; i--)
+// --- Deterministic (1-2-3) Balancing ---
+// A node of level i is "in the gap" of the closest node to its left that is taller than
+// i (or of the header). In deterministic mode every gap on every level holds 1 to 3
+// nodes, which makes the list a 2-3-4 tree: the height is at most log2(n) + 1 and a
+// search looks at no more than 3 nodes per level. Insert splits full gaps on the way
+// down by raising their middle node; delete refills an emptied gap by borrowing from
+// or merging with a neighbouring gap. Towers are inline, so a node that changes
+// height is moved to a new allocation. If that allocation fails the repair stops and
+// gaps may be left empty or overfull; every level is still correctly linked, and the
+// operations below check what they rely on, so the list stays correct, only less
+// balanced.
+
+// Nodes in the gap that s owns on level i
+static int gap_size(const SkipListNode *s, int i)
+{
+    int count = 0;
+    for (const SkipListNode *n = s->forward[i]; n && n->level == i; n = n->forward[i])
     {
-        // Traverse right while next node's key is less than search_key
-        while (current->forward[i] && current->forward[i]->key < search_key)
+        count++;
+    }
+    return count;
+}
+
+// Fills update[] with the last node before key on every level up to the cap and
+// returns the node holding key (the header for key -1), or NULL
+static SkipListNode *locate(SkipList *list, int key, SkipListNode **update)
+{
+    SkipListNode *current = list->header;
+    for (int i = list->max_level - 1; i >= 0; i--)
+    {
+        while (current->forward[i] && current->forward[i]->key < key)
         {
             current = current->forward[i];
         }
+        update[i] = current;
     }
-
-    // Moved down to level 0. The next node (if it exists) is the candidate.
+    if (key < 0)
+        return list->header;
     current = current->forward[0];
+    return (current && current->key == key) ? current : NULL;
+}
 
-    // Check if the candidate node exists and its key matches
-    if (current && current->key == search_key)
+// Moves node into a new allocation with new_level levels and relinks it.
+// update[] holds its predecessors on every level up to the higher of the two heights.
+static SkipListNode *resize_node(SkipList *list, SkipListNode *node, int new_level, SkipListNode **update)
+{
+    SkipListNode *copy = create_data_node(list, new_level, node->key, skiplist_record(list, node));
+    if (!copy)
+        return NULL;
+    copy->flags = node->flags; // The deadline table is keyed by key, so it needs no update
+    // A compact record moves with its node, so a cached pointer would dangle
+    if (list->compact && list->cache)
+        cache_invalidate(list->cache, node->key);
+
+    int top = node->level > new_level ? node->level : new_level;
+    for (int i = 0; i <= top; i++)
     {
-        return current->value; // Return pointer to the Record
+        SkipListNode *next = (i <= node->level) ? node->forward[i] : update[i]->forward[i];
+        if (i <= new_level)
+        {
+            copy->forward[i] = next;
+            update[i]->forward[i] = copy;
+            if (!next)
+                list->tail[i] = copy;
+        }
+        else
+        {
+            update[i]->forward[i] = next; // Dropped from this level
+            if (list->tail[i] == node)
+                list->tail[i] = (update[i] == list->header) ? NULL : update[i];
+        }
     }
-    else
+
+    list->level_counts[node->level]--;
+    list->level_counts[new_level]++;
+    if (new_level > list->level)
+        list->level = new_level;
+    while (list->level > 0 && list->header->forward[list->level] == NULL)
     {
-        return NULL; // Not found
+        list->level--;
     }
+    // The record now belongs to the new node (or was copied into it)
+    arena_free(list->arena, node, data_node_size(list, node->level));
+    return copy;
 }
 
-int insert_skiplist(SkipList *list, int key, Record *value)
+// Gives the node holding key a new height. Returns 0 if it could not be moved.
+static int set_level(SkipList *list, int key, int new_level)
 {
-    if (!list || !value || key < 0)
-        return 0; // Basic validation
+    SkipListNode *update[MAX_LEVEL];
+    SkipListNode *node = locate(list, key, update);
+    return node && resize_node(list, node, new_level, update) != NULL;
+}
 
-    SkipListNode *update[MAX_LEVEL]; // Array to store pointers to nodes that need updating
-    SkipListNode *current = list->header;
+// Insert, top down: every full gap on the path to key is split by raising its middle
+// node, so the gap the new level-0 node lands in has room. update[0] is set to the
+// new node's predecessor.
+static void split_full_gaps(SkipList *list, int key, SkipListNode **update)
+{
+    // A full top gap starts a new level (grow_level_cap made room for it)
+    if (gap_size(list->header, list->level) == 3 && list->level + 1 < list->max_level)
+    {
+        SkipListNode *first = list->header->forward[list->level];
+        set_level(list, first->forward[list->level]->key, list->level + 1);
+    }
 
-    // Find insertion points at each level and store predecessors in update[]
-    for (int i = list->level; i >= 0; i--)
+    SkipListNode *current = list->header;
+    for (int i = list->level; i > 0; i--)
     {
         while (current->forward[i] && current->forward[i]->key < key)
         {
             current = current->forward[i];
         }
-        update[i] = current; // Store the node where we moved down
+        if (gap_size(current, i - 1) == 3)
+        {
+            // Raising a node after current leaves current where it is
+            set_level(list, current->forward[i - 1]->forward[i - 1]->key, i);
+            while (current->forward[i] && current->forward[i]->key < key)
+            {
+                current = current->forward[i];
+            }
+        }
     }
-
-    // Move to the potential insertion point at level 0
-    current = current->forward[0];
-
-    // Check if key already exists
-    if (current && current->key == key)
+    while (current->forward[0] && current->forward[0]->key < key)
     {
-        // Optionally update the existing value? For now, treat as duplicate error.
-        // free(value); // Free the passed-in record if we don't insert it
-        return 0; // Duplicate key found
+        current = current->forward[0];
     }
+    update[0] = current;
+}
 
-    // Key doesn't exist, proceed with insertion
-    int new_level = random_level();
+// Delete, bottom up: the gap that the node holding s_key (-1 = header) owns on level i
+// has become empty. A neighbouring gap under the same parent lends a node if it has two
+// or more; otherwise the two gaps merge, which takes a node out of the parent gap and
+// may empty that one in turn.
+static void fill_gap(SkipList *list, int s_key, int i)
+{
+    SkipListNode *update[MAX_LEVEL];
+    while (i < list->level)
+    {
+        SkipListNode *s = locate(list, s_key, update);
+        SkipListNode *t = s->forward[i + 1];
+        int right = t && t->level == i + 1;                 // t's gap is the next one
+        int left = s != list->header && s->level == i + 1; // update[i + 1]'s gap is the previous one
+        SkipListNode *lowered;
 
-    // If the new node's level is higher than the current list level,
-    // update the list level and initialize update pointers for new levels.
-    if (new_level > list->level)
+        if (right && gap_size(t, i) >= 2)
+        {
+            // t drops into the empty gap; the first node of its gap takes its place
+            int t_key = t->key;
+            if (set_level(list, t_key, i))
+                set_level(list, locate(list, t_key, update)->forward[i]->key, i + 1);
+            return;
+        }
+        if (left && gap_size(update[i + 1], i) >= 2)
+        {
+            // s drops into the previous gap; the last node of that gap takes its place
+            if (set_level(list, s_key, i))
+            {
+                locate(list, s_key, update);
+                set_level(list, update[i]->key, i + 1);
+            }
+            return;
+        }
+        if (right)
+            lowered = t; // Merge with the next gap
+        else if (left)
+            lowered = s; // Merge with the previous gap
+        else
+            return;
+
+        int lowered_key = lowered->key;
+        if (!set_level(list, lowered_key, i))
+            return;
+        locate(list, lowered_key, update);
+        SkipListNode *owner = update[i + 2 < list->max_level ? i + 2 : list->max_level - 1];
+        if (i + 2 >= list->max_level || gap_size(owner, i + 1) > 0)
+            return;
+        s_key = (owner == list->header) ? -1 : owner->key;
+        i++;
+    }
+}
+
+// Unlinks node (found with update[] as its predecessors) and frees it, keeping every gap
+// non-empty. A tall node hands its place to the first node of its level-0 gap instead:
+// that node's key and record move into it and the short node is the one removed.
+// Returns 0, having changed nothing, if that gap is empty (left so by a failed
+// allocation); the caller then unlinks node on every level.
+static int unlink_balanced(SkipList *list, SkipListNode *node, SkipListNode **update)
+{
+    SkipListNode *owner;
+    if (node->level > 0)
     {
-        for (int i = list->level + 1; i <= new_level; i++)
+        SkipListNode *next = node->forward[0];
+        if (!next || next->level != 0)
+            return 0;
+        if (list->compact)
         {
-            update[i] = list->header; // New levels point back to header
+            if (list->cache)
+                cache_invalidate(list->cache, next->key); // Its record is copied, not moved
+            *skiplist_record(list, node) = *skiplist_record(list, next);
         }
-        list->level = new_level; // Update the list's max level
+        else
+        {
+            free_record_in(list->arena, *record_slot(node));
+            *record_slot(node) = *record_slot(next);
+            *record_slot(next) = NULL;
+        }
+        node->key = next->key;
+        node->flags = next->flags; // The caller already cleared the deadline of the removed key
+        owner = node;
+        update[0] = node;
+        node = next;
+    }
+    else
+    {
+        owner = (list->level > 0) ? update[1] : list->header;
     }
 
-    // Create the new node
-    SkipListNode *new_node = create_node(new_level, key, value);
-    if (!new_node)
-        return 0; // Allocation failed
+    update[0]->forward[0] = node->forward[0];
+    if (list->tail[0] == node)
+        list->tail[0] = (update[0] == list->header) ? NULL : update[0];
+    list->level_counts[0]--;
+    release_node(list, node);
 
-    // Insert the new node by updating forward pointers
-    for (int i = 0; i <= new_level; i++)
+    if (gap_size(owner, 0) == 0)
+        fill_gap(list, (owner == list->header) ? -1 : owner->key, 0);
+    return 1;
+}
+
+// Level of the pos-th node (1-based) in a perfectly balanced list. counts[i] is the
+// number of nodes reaching level i: every second one of them also reaches level i + 1,
+// except that the last one stays behind when counts[i] is even, so no gap is empty.
+static int balanced_level(size_t pos, const size_t *counts)
+{
+    int level = 0;
+    while (counts[level] >= 4 && pos % 2 == 0 && pos != counts[level])
     {
-        new_node->forward[i] = update[i]->forward[i]; // New node points to what update[i] was pointing to
-        update[i]->forward[i] = new_node;             // update[i] now points to the new node
+        pos /= 2;
+        level++;
     }
+    return level;
+}
 
-    list->size++;
-    return 1; // Insertion successful
+// Re-towers a deterministic list after a bulk relink, in one pass over level 0
+static void rebalance(SkipList *list)
+{
+    size_t counts[MAX_LEVEL + 1] = {list->size};
+    int top = 0;
+    while (top + 1 < MAX_LEVEL && counts[top] >= 4)
+    {
+        counts[top + 1] = counts[top] / 2 - (counts[top] % 2 == 0 ? 1 : 0);
+        top++;
+    }
+    if (!grow_level_cap(list, list->size, top))
+        return;
+
+    SkipListNode *last[MAX_LEVEL];
+    SkipListNode *node = list->header->forward[0];
+    size_t pos = 0;
+    begin_relink(list, last);
+    while (node)
+    {
+        SkipListNode *next = node->forward[0];
+        int level = balanced_level(++pos, counts);
+        if (level != node->level)
+        {
+            SkipListNode *copy = create_data_node(list, level, node->key, skiplist_record(list, node));
+            if (copy)
+            {
+                copy->flags = node->flags;
+                arena_free(list->arena, node, data_node_size(list, node->level));
+                node = copy;
+            }
+        }
+        append_node(list, last, node);
+        node = next;
+    }
+    finish_relink(list, last);
+    if (list->compact && list->cache)
+        cache_clear(list->cache); // Records moved with their nodes
 }
 
-int delete_skiplist(SkipList *list, int key)
+// After a split or concat, bottom up: on each level only the gap around the cut (the
+// position of key) can be empty or overfull. An empty one takes in the next taller node
+// and its gap, or, at the end of the list, its owner drops into the gap before it; an
+// overfull one is split by raising its middle node. Either change only adds a node to
+// or takes one from the cut's gap one level up, so each level moves at most two towers.
+static void repair_cut(SkipList *list, int key)
 {
-    if (!list || key < 0)
-        return 0;
+    SkipListNode *update[MAX_LEVEL];
+    for (int i = 0; i <= list->level; i++)
+    {
+        grow_level_cap(list, list->size, list->level + 1); // Failure only rules out a new top level
+        locate(list, key, update);
+        SkipListNode *owner = (i < list->level) ? update[i + 1] : list->header;
+        if (gap_size(owner, i) == 0)
+        {
+            SkipListNode *next = owner->forward[i]; // Taller than i, or NULL
+            if (next ? !set_level(list, next->key, i) : (owner == list->header || !set_level(list, owner->key, i)))
+                return;
+            locate(list, key, update);
+            owner = (i < list->level) ? update[i + 1] : list->header;
+        }
 
+        int gap = gap_size(owner, i);
+        if (gap > 3 && i + 1 < list->max_level)
+        {
+            SkipListNode *middle = owner->forward[i];
+            for (int k = 0; k < (gap - 1) / 2; k++)
+            {
+                middle = middle->forward[i];
+            }
+            set_level(list, middle->key, i + 1);
+        }
+    }
+}
+
+// Unlinks key and frees its node and record. With now != 0 the node is only
+// removed if its TTL has run out by then (stale wheel entries are ignored).
+// Returns 1 if a node was removed.
+static int remove_key(SkipList *list, int key, time_t now)
+{
     SkipListNode *update[MAX_LEVEL];
     SkipListNode *current = list->header;
 
@@ -186,7 +660,21 @@ int delete_skiplist(SkipList *list, int key)
     current = current->forward[0];
 
     // Check if the node exists and key matches
-    if (current && current->key == key)
+    if (!current || current->key != key || (now != 0 && !is_expired(list, current, now)))
+        return 0; // Key not found (or not expired)
+
+    // Free the node and its associated Record data
+    if (list->cache)
+        cache_invalidate(list->cache, key);
+    if (list->filter)
+        cuckoo_remove(list->filter, key);
+    if (list->column)
+        column_remove(list->column, key);
+    if (now != 0)
+        list->ttl->expired++;
+    clear_deadline(list, current);
+
+    if (!list->deterministic || !unlink_balanced(list, current, update))
     {
         // Update forward pointers to bypass the node to be deleted
         for (int i = 0; i <= current->level; i++)
@@ -196,59 +684,973 @@ int delete_skiplist(SkipList *list, int key)
             {
                 update[i]->forward[i] = current->forward[i];
             }
+            if (list->tail[i] == current)
+            {
+                list->tail[i] = (update[i] == list->header) ? NULL : update[i];
+            }
         }
+        list->level_counts[current->level]--;
+        release_node(list, current);
+    }
 
-        // Free the associated Record data first!
-        if (current->value)
-        {
-            free(current->value);
-        }
-        // Free the forward pointers array of the node
-        free(current->forward);
-        // Free the node itself
-        free(current);
+    // Update the list level if the deleted node was the tallest
+    // Check from top down if levels are now empty
+    while (list->level > 0 && list->header->forward[list->level] == NULL)
+    {
+        list->level--;
+    }
 
-        // Update the list level if the deleted node was the tallest
-        // Check from top down if levels are now empty
-        while (list->level > 0 && list->header->forward[list->level] == NULL)
-        {
-            list->level--;
-        }
+    list->size--;
+    return 1;
+}
 
-        list->size--;
-        return 1; // Deletion successful
-    }
+// --- Core Skip List Operations ---
 
-    return 0; // Key not found
+void skiplist_default_options(SkipListOptions *opts)
+{
+    opts->use_arena = 0;
+    arena_default_options(&opts->arena);
+    opts->p = SKIPLIST_P;
+    opts->cache_entries = 0;
+    opts->use_filter = 0;
+    opts->use_column = 0;
+    opts->compact = 0;
+    opts->deterministic = 0;
+    opts->seed = 0;
 }
 
-void free_skiplist(SkipList *list)
+SkipList *create_skiplist()
 {
-    if (!list)
-        return;
+    return create_skiplist_ex(NULL);
+}
 
-    SkipListNode *current = list->header->forward[0]; // Start at the first actual node
-    SkipListNode *next;
+SkipList *create_skiplist_ex(const SkipListOptions *opts)
+{
+    SkipListOptions defaults;
+    if (!opts)
+    {
+        skiplist_default_options(&defaults);
+        opts = &defaults;
+    }
+
+    SkipList *list = (SkipList *)malloc(sizeof(SkipList));
+    if (!list)
+        return NULL;
+
+    list->p = (opts->p > 0.0 && opts->p < 1.0) ? opts->p : SKIPLIST_P;
+    list->max_level = SKIPLIST_MIN_LEVEL;
+    list->grow_at = 1.0;
+    for (int i = 1; i < list->max_level; i++)
+    {
+        list->grow_at /= list->p; // (1/p)^(max_level - 1)
+    }
+    memset(list->level_counts, 0, sizeof(list->level_counts));
+
+    memset(list->tail, 0, sizeof(list->tail));
+    list->append_hits = 0;
+    list->arena = NULL;
+    list->cache = NULL;
+    list->filter = NULL;
+    list->column = NULL;
+    list->ttl = NULL;
+    list->compact = opts->compact;
+    list->deterministic = opts->deterministic;
+    list->rng = opts->seed ? opts->seed : (uint32_t)rand();
+    if (list->rng == 0)
+        list->rng = 1; // xorshift would stay at 0
+
+    // Create header node with minimum key value (or sentinel) and the current level cap
+    // Key = -1 assumes IDs are non-negative. Adjust if necessary.
+    // The header is always malloc'd (it is realloc'd as the cap grows); only data nodes live in the arena.
+    list->header = create_node(NULL, node_size(list->max_level - 1), list->max_level - 1, -1); // Max level index
+
+    // Optional components; any allocation failure fails the whole list
+    if (!list->header ||
+        (opts->use_arena && !(list->arena = arena_create(&opts->arena))) ||
+        (opts->cache_entries > 0 && !(list->cache = cache_create(opts->cache_entries))) ||
+        (opts->use_filter && !(list->filter = cuckoo_create(CUCKOO_SLOTS))) ||
+        (opts->use_column && !(list->column = column_create())))
+    {
+        free_components(list);
+        free(list);
+        return NULL;
+    }
+
+    list->level = 0; // Initially, list level is 0
+    list->size = 0;
+
+    return list;
+}
+
+Record *search_skiplist(SkipList *list, int search_key)
+{
+    if (!list)
+        return NULL;
+
+    // Hot keys are answered straight from the lookaside cache
+    if (list->cache)
+    {
+        Record *cached = cache_lookup(list->cache, search_key);
+        if (cached)
+            return cached;
+    }
+
+    // Absent keys usually stop here, after a couple of hashes
+    if (list->filter && !cuckoo_contains(list->filter, search_key))
+    {
+        list->filter->negatives++;
+        return NULL;
+    }
+
+    SkipListNode *current = list->header;
+
+    // Start from the highest level of the list
+    for (int i = list->level; i >= 0; i--)
+    {
+        // Traverse right while next node's key is less than search_key
+        while (current->forward[i] && current->forward[i]->key < search_key)
+        {
+            current = current->forward[i];
+        }
+    }
+
+    // Moved down to level 0. The next node (if it exists) is the candidate.
+    current = current->forward[0];
+
+    // Check if the candidate node exists and its key matches
+    if (current && current->key == search_key)
+    {
+        Record *rec = skiplist_record(list, current);
+        if (current->flags & NODE_HAS_TTL)
+        {
+            // Expiry is checked lazily here. Records with a TTL are never cached,
+            // since a cache hit would skip this check.
+            if (remove_key(list, search_key, time(NULL)))
+                return NULL;
+            return rec;
+        }
+        if (list->cache)
+            cache_insert(list->cache, search_key, rec);
+        return rec; // Return pointer to the Record
+    }
+    else
+    {
+        if (list->filter)
+            list->filter->false_positives++;
+        return NULL; // Not found
+    }
+}
+
+// One lookup of a batch, suspended while the node it needs next is being prefetched
+typedef struct
+{
+    size_t index;       // Position in the batch (keys[index], out[index])
+    int key;
+    int level;          // Level being walked
+    SkipListNode *node; // Last node known to be < key (header at first)
+    SkipListNode *next; // node->forward[level], prefetched when the lookup was suspended
+} BatchLookup;
+
+// Takes the next key that needs a descent; keys answered by the cache or
+// rejected by the filter are resolved on the spot. Returns 0 when none are left.
+static int start_lookup(SkipList *list, BatchLookup *s, const int *keys, size_t n, size_t *pos, Record **out)
+{
+    while (*pos < n)
+    {
+        size_t i = (*pos)++;
+        int key = keys[i];
+        if (list->cache && (out[i] = cache_lookup(list->cache, key)) != NULL)
+            continue;
+        if (list->filter && !cuckoo_contains(list->filter, key))
+        {
+            list->filter->negatives++;
+            out[i] = NULL;
+            continue;
+        }
+        s->index = i;
+        s->key = key;
+        s->level = list->level;
+        s->node = list->header;
+        s->next = list->header->forward[s->level];
+        PREFETCH(s->next);
+        return 1;
+    }
+    return 0;
+}
+
+void skiplist_search_batch(SkipList *list, const int *keys, size_t n, Record **out)
+{
+    if (!list)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = NULL;
+        }
+        return;
+    }
+
+    BatchLookup active[SKIPLIST_BATCH_WIDTH];
+    int count = 0;
+    size_t pos = 0;
+    time_t now = time(NULL);
+
+    while (count < SKIPLIST_BATCH_WIDTH && start_lookup(list, &active[count], keys, n, &pos, out))
+    {
+        count++;
+    }
+
+    // Round-robin: each lookup takes one step (one node it prefetched a round ago),
+    // prefetches the node it needs next, and yields to the others
+    while (count > 0)
+    {
+        for (int j = 0; j < count;)
+        {
+            BatchLookup *s = &active[j];
+            if (s->next && s->next->key < s->key)
+            {
+                s->node = s->next; // Move right on this level
+            }
+            else if (s->level > 0)
+            {
+                s->level--; // Drop down a level
+            }
+            else
+            {
+                // Done: s->next is the candidate at level 0
+                SkipListNode *found = (s->next && s->next->key == s->key) ? s->next : NULL;
+                out[s->index] = found ? skiplist_record(list, found) : NULL;
+                if (found && (found->flags & NODE_HAS_TTL))
+                {
+                    // Unlinking here would pull nodes from under the other lookups;
+                    // expired records are just hidden and left to the timing wheel
+                    if (is_expired(list, found, now))
+                        out[s->index] = NULL;
+                }
+                else if (found && list->cache)
+                {
+                    cache_insert(list->cache, s->key, out[s->index]);
+                }
+                else if (!found && list->filter)
+                {
+                    list->filter->false_positives++;
+                }
+
+                // Reuse the slot for the next key, or close the gap
+                if (!start_lookup(list, s, keys, n, &pos, out))
+                {
+                    active[j] = active[--count];
+                    continue;
+                }
+                j++;
+                continue;
+            }
+            s->next = s->node->forward[s->level];
+            PREFETCH(s->next);
+            j++;
+        }
+    }
+}
+
+int insert_skiplist(SkipList *list, int key, Record *value)
+{
+    if (!list || !value || key < 0)
+        return 0; // Basic validation
+
+    // Reclaim a few expired records before the list grows further
+    skiplist_reap(list, TTL_REAP_PER_OP);
+
+    // A deterministic insert may have to start a new level
+    if (!grow_level_cap(list, list->size + 1, list->deterministic ? list->level + 1 : 0))
+        return 0; // Allocation failed
+
+    SkipListNode *update[MAX_LEVEL]; // Array to store pointers to nodes that need updating
+    SkipListNode *current = list->header;
+
+    if (!list->deterministic && (!list->tail[0] || list->tail[0]->key < key))
+    {
+        // Appending past the largest key: the tail finger already holds the
+        // predecessor at every level, so no descent is needed
+        for (int i = list->level; i >= 0; i--)
+        {
+            update[i] = list->tail[i] ? list->tail[i] : list->header;
+        }
+        list->append_hits++;
+    }
+    else
+    {
+        // Find insertion points at each level and store predecessors in update[]
+        for (int i = list->level; i >= 0; i--)
+        {
+            while (current->forward[i] && current->forward[i]->key < key)
+            {
+                current = current->forward[i];
+            }
+            update[i] = current; // Store the node where we moved down
+        }
+
+        // Move to the potential insertion point at level 0
+        current = current->forward[0];
+
+        // Check if key already exists
+        if (current && current->key == key)
+        {
+            // An expired record that has not been reclaimed yet gives way to the new one
+            if ((current->flags & NODE_HAS_TTL) && remove_key(list, key, time(NULL)))
+                return insert_skiplist(list, key, value);
+            // Optionally update the existing value? For now, treat as duplicate error.
+            // free(value); // Free the passed-in record if we don't insert it
+            return 0; // Duplicate key found
+        }
+    }
+
+    // Key doesn't exist, proceed with insertion
+    int new_level = 0;
+    if (list->deterministic)
+        split_full_gaps(list, key, update); // New nodes always start at level 0
+    else
+        new_level = random_level(list);
+
+    // If the new node's level is higher than the current list level,
+    // update the list level and initialize update pointers for new levels.
+    if (new_level > list->level)
+    {
+        for (int i = list->level + 1; i <= new_level; i++)
+        {
+            update[i] = list->header; // New levels point back to header
+        }
+        list->level = new_level; // Update the list's max level
+    }
+
+    // Create the new node
+    SkipListNode *new_node = create_data_node(list, new_level, key, value);
+    if (!new_node)
+        return 0; // Allocation failed
+    if (list->compact)
+    {
+        free_record_in(list->arena, value); // The node holds its own copy
+        value = skiplist_record(list, new_node);
+    }
+
+    // Insert the new node by updating forward pointers
+    for (int i = 0; i <= new_level; i++)
+    {
+        new_node->forward[i] = update[i]->forward[i]; // New node points to what update[i] was pointing to
+        update[i]->forward[i] = new_node;             // update[i] now points to the new node
+        if (!new_node->forward[i])
+        {
+            list->tail[i] = new_node; // New last node on this level
+        }
+    }
+
+    list->level_counts[new_level]++;
+    list->size++;
+
+    if (list->filter && (!cuckoo_insert(list->filter, key) || cuckoo_needs_growth(list->filter)))
+    {
+        rebuild_filter(list);
+    }
+    if (list->column && !column_insert(list->column, key, value->value))
+    {
+        // A partial copy would give wrong aggregates; fall back to walking the list
+        fprintf(stderr, "Warning: could not grow value column, disabling it.\n");
+        column_destroy(list->column);
+        list->column = NULL;
+    }
+    return 1; // Insertion successful
+}
+
+int delete_skiplist(SkipList *list, int key)
+{
+    if (!list || key < 0)
+        return 0;
+
+    int removed = remove_key(list, key, 0);
+    skiplist_reap(list, TTL_REAP_PER_OP);
+    return removed;
+}
+
+int update_skiplist(SkipList *list, int key, const char *name, double value)
+{
+    Record *rec = search_skiplist(list, key);
+    if (!rec)
+        return 0; // Key not found
+
+    // Update in-place (key doesn't change). The Record pointer stays the same,
+    // so a cached entry for this key remains valid.
+    strncpy(rec->name, name, MAX_NAME_LEN - 1);
+    rec->name[MAX_NAME_LEN - 1] = '\0';
+    rec->value = value;
+    if (list->column)
+        column_set(list->column, key, value);
+    return 1;
+}
+
+void skiplist_aggregate(SkipList *list, int lo, int hi, Aggregate *out)
+{
+    if (list && list->column)
+    {
+        column_aggregate(list->column, lo, hi, out);
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    if (!list)
+        return;
+
+    // No columnar copy: descend to lo, then gather values from level 0 in batches
+    SkipListNode *current = list->header;
+    for (int i = list->level; i >= 0; i--)
+    {
+        while (current->forward[i] && current->forward[i]->key < lo)
+        {
+            current = current->forward[i];
+        }
+    }
+    current = current->forward[0];
+
+    double batch[256];
+    size_t n = 0;
+    while (current && current->key <= hi)
+    {
+        batch[n++] = skiplist_record(list, current)->value;
+        if (n == sizeof(batch) / sizeof(batch[0]))
+        {
+            aggregate_values(batch, n, out);
+            n = 0;
+        }
+        current = current->forward[0];
+    }
+    aggregate_values(batch, n, out);
+}
+
+int skiplist_promote(SkipList *list, int key)
+{
+    if (!list || key < 0 || list->deterministic)
+        return 0; // Deterministic towers are set by the gap rule alone
+
+    SkipListNode *update[MAX_LEVEL];
+    SkipListNode *current = list->header;
+
+    for (int i = list->level; i >= 0; i--)
+    {
+        while (current->forward[i] && current->forward[i]->key < key)
+        {
+            current = current->forward[i];
+        }
+        update[i] = current;
+    }
+
+    SkipListNode *old = current->forward[0];
+    if (!old || old->key != key)
+        return 0; // Key not found
+
+    // Already as tall as any node in the list
+    int new_level = list->level;
+    if (old->level >= new_level)
+        return 1;
+
+    // Towers are inline, so re-tower by moving the record into a taller node
+    return resize_node(list, old, new_level, update) != NULL;
+}
+
+int skiplist_expire_at(SkipList *list, int key, time_t when)
+{
+    if (!list || key < 0)
+        return 0;
+
+    SkipListNode *current = list->header;
+    for (int i = list->level; i >= 0; i--)
+    {
+        while (current->forward[i] && current->forward[i]->key < key)
+        {
+            current = current->forward[i];
+        }
+    }
+    current = current->forward[0];
+
+    time_t now = time(NULL);
+    if (!current || current->key != key || is_expired(list, current, now))
+        return 0; // Key not found (an expired record counts as gone)
+
+    if (when == 0)
+    {
+        clear_deadline(list, current);
+        return 1;
+    }
+    if (when <= now)
+        return remove_key(list, key, 0);
+
+    if (!set_deadline(list, current, when, now))
+        return 0;
+    // The record may have been cached while it had no TTL
+    if (list->cache)
+        cache_invalidate(list->cache, key);
+    return 1;
+}
+
+long skiplist_ttl(SkipList *list, int key)
+{
+    if (!list || key < 0)
+        return -2;
+
+    SkipListNode *current = list->header;
+    for (int i = list->level; i >= 0; i--)
+    {
+        while (current->forward[i] && current->forward[i]->key < key)
+        {
+            current = current->forward[i];
+        }
+    }
+    current = current->forward[0];
+
+    time_t now = time(NULL);
+    if (!current || current->key != key || is_expired(list, current, now))
+        return -2;
+    time_t when = skiplist_deadline(list, current);
+    if (when == 0)
+        return -1;
+    return (long)(when - now);
+}
+
+size_t skiplist_reap(SkipList *list, size_t max)
+{
+    if (!list || !list->ttl || list->ttl->pending == 0)
+        return 0;
+
+    int keys[TTL_REAP_PER_OP];
+    if (max > TTL_REAP_PER_OP)
+        max = TTL_REAP_PER_OP;
+
+    time_t now = time(NULL);
+    size_t due = ttl_wheel_expire(list->ttl, now, keys, max);
+    size_t reclaimed = 0;
+    for (size_t i = 0; i < due; i++)
+    {
+        // The node decides: the entry may be stale (deleted, re-added or TTL changed)
+        reclaimed += (size_t)remove_key(list, keys[i], now);
+    }
+    return reclaimed;
+}
+
+size_t skiplist_merge(SkipList *dest, SkipList *src, SkipListConflict policy)
+{
+    if (!dest || !src || dest == src)
+        return 0;
+
+    // Adopted nodes keep their towers, which may be taller than dest allows so far
+    if (!grow_level_cap(dest, dest->size + src->size, src->max_level - 1))
+        return 0;
+
+    time_t now = time(NULL);
+    SkipListNode *last[MAX_LEVEL];
+    SkipListNode *d = dest->header->forward[0];
+    SkipListNode *s = src->header->forward[0];
+    size_t taken = 0;
+    size_t dropped = 0;
+
+    begin_relink(dest, last);
+    while (d || s)
+    {
+        SkipListNode *node;
+        if (!s || (d && d->key < s->key))
+        {
+            node = d;
+            d = d->forward[0];
+        }
+        else
+        {
+            SkipListNode *next = s->forward[0];
+            SkipListNode *replaced = (d && d->key == s->key) ? d : NULL;
+            if ((replaced && policy == SKIPLIST_KEEP_DEST && !is_expired(dest, d, now)) || is_expired(src, s, now))
+            {
+                release_node(src, s); // d, if any, is appended on the next round
+                s = next;
+                continue;
+            }
+
+            time_t when = skiplist_deadline(src, s);
+            node = adopt_node(dest, src, s);
+            if (node != s)
+                release_node(src, s);
+            s = next;
+            if (node && when != 0 && !set_deadline(dest, node, when, now))
+            {
+                release_node(dest, node); // A record must not outlive its TTL
+                node = NULL;
+            }
+            if (!node)
+            {
+                dropped++; // d, if any, stays
+                continue;
+            }
+            if (replaced)
+            {
+                // Only now that its successor is in hand; any wheel entry it had goes stale
+                d = d->forward[0];
+                if (when == 0)
+                    clear_deadline(dest, replaced); // Otherwise node's deadline replaced it
+                release_node(dest, replaced);
+            }
+            taken++;
+        }
+        append_node(dest, last, node);
+    }
+    finish_relink(dest, last);
+    if (dest->deterministic)
+        rebalance(dest);
+    refresh_components(dest);
+
+    // Every node of src was adopted or freed above
+    begin_relink(src, last);
+    finish_relink(src, last);
+    ttl_wheel_destroy(src->ttl);
+    src->ttl = NULL;
+    refresh_components(src);
+
+    if (dropped > 0)
+        fprintf(stderr, "Warning: out of memory, %lu merged records were dropped.\n", (unsigned long)dropped);
+    return taken;
+}
+
+// Keeps the nodes of list whose key is (keep_common) or is not (!keep_common) live in other.
+// Returns the number of records removed.
+static size_t filter_by(SkipList *list, const SkipList *other, int keep_common)
+{
+    if (!list || !other || list == other)
+        return 0;
+
+    time_t now = time(NULL);
+    SkipListNode *last[MAX_LEVEL];
+    SkipListNode *node = list->header->forward[0];
+    const SkipListNode *o = other->header->forward[0];
+    size_t before = list->size;
+
+    begin_relink(list, last);
+    while (node)
+    {
+        SkipListNode *next = node->forward[0];
+        while (o && o->key < node->key)
+        {
+            o = o->forward[0];
+        }
+        int common = o && o->key == node->key && !is_expired(other, o, now);
+        if (common == keep_common)
+        {
+            append_node(list, last, node);
+        }
+        else
+        {
+            clear_deadline(list, node);
+            release_node(list, node);
+        }
+        node = next;
+    }
+    finish_relink(list, last);
+    if (list->deterministic)
+        rebalance(list);
+    refresh_components(list);
+    return before - list->size;
+}
+
+size_t skiplist_intersect(SkipList *list, const SkipList *other)
+{
+    return filter_by(list, other, 1);
+}
+
+size_t skiplist_subtract(SkipList *list, const SkipList *other)
+{
+    return filter_by(list, other, 0);
+}
+
+// Sets size and level_counts of two lists whose chains were just cut apart (total and
+// counts describe them together). Both chains are walked in step and the walk stops
+// when the shorter one ends, so the cost is that of the smaller side.
+static void count_halves(SkipList *left, SkipList *right, size_t total, const size_t *counts)
+{
+    SkipListNode *a = left->header->forward[0];
+    SkipListNode *b = right->header->forward[0];
+    size_t left_counts[MAX_LEVEL] = {0};
+    size_t right_counts[MAX_LEVEL] = {0};
+    size_t left_size = 0;
+    size_t right_size = 0;
+
+    while (a && b)
+    {
+        left_counts[a->level]++;
+        right_counts[b->level]++;
+        left_size++;
+        right_size++;
+        a = a->forward[0];
+        b = b->forward[0];
+    }
+
+    SkipList *done = a ? right : left; // The side walked to its end
+    SkipList *rest = a ? left : right;
+    const size_t *done_counts = a ? right_counts : left_counts;
+    done->size = a ? right_size : left_size;
+    rest->size = total - done->size;
+    for (int i = 0; i < MAX_LEVEL; i++)
+    {
+        done->level_counts[i] = done_counts[i];
+        rest->level_counts[i] = counts[i] - done_counts[i];
+    }
+}
+
+SkipList *skiplist_split(SkipList *list, int key)
+{
+    if (!list)
+        return NULL;
+
+    // The new list gets the same configuration; its column, wheel and arena come from list
+    SkipListOptions opts;
+    skiplist_default_options(&opts);
+    opts.p = list->p;
+    opts.compact = list->compact;
+    opts.cache_entries = list->cache ? cache_capacity(list->cache) : 0;
+    opts.use_filter = list->filter != NULL;
+    opts.deterministic = list->deterministic;
+    opts.seed = next_random(list);
+    SkipList *upper = create_skiplist_ex(&opts);
+    if (!upper || !grow_level_cap(upper, 0, list->level))
+    {
+        free_skiplist(upper);
+        return NULL;
+    }
+    if ((list->column && !(upper->column = column_split(list->column, key))) ||
+        (list->ttl && !(upper->ttl = ttl_wheel_split(list->ttl, key))))
+    {
+        // Undo the column cut (a failed wheel split undoes itself)
+        if (upper->column)
+            column_concat(list->column, upper->column);
+        free_skiplist(upper);
+        return NULL;
+    }
+    upper->arena = arena_retain(list->arena); // Nodes stay where they are
+
+    // Last node before key on each level; everything after it moves
+    SkipListNode *current = list->header;
+    for (int i = list->level; i >= 0; i--)
+    {
+        while (current->forward[i] && current->forward[i]->key < key)
+        {
+            current = current->forward[i];
+        }
+        if (current->forward[i])
+        {
+            upper->header->forward[i] = current->forward[i];
+            upper->tail[i] = list->tail[i];
+            current->forward[i] = NULL;
+            list->tail[i] = (current == list->header) ? NULL : current;
+            if (upper->level == 0)
+                upper->level = i;
+        }
+    }
+    while (list->level > 0 && list->header->forward[list->level] == NULL)
+    {
+        list->level--;
+    }
+
+    size_t counts[MAX_LEVEL];
+    memcpy(counts, list->level_counts, sizeof(counts));
+    count_halves(list, upper, list->size, counts);
+    grow_level_cap(upper, upper->size, 0); // Only a larger cap; failure is harmless
+    if (list->deterministic)
+    {
+        // The cut leaves short gaps along its edge on both sides
+        repair_cut(list, key);
+        repair_cut(upper, key);
+    }
+
+    // Records that moved may be cached; the filter keeps their fingerprints, which
+    // only costs false positives until it is next rebuilt
+    if (list->cache)
+        cache_clear(list->cache);
+    if (upper->filter)
+    {
+        // The new list's filter starts empty; the column already came from column_split
+        int ok = 1;
+        for (SkipListNode *node = upper->header->forward[0]; node && ok; node = node->forward[0])
+        {
+            ok = cuckoo_insert(upper->filter, node->key);
+        }
+        if (!ok || cuckoo_needs_growth(upper->filter))
+            rebuild_filter(upper);
+    }
+    return upper;
+}
+
+int skiplist_concat(SkipList *left, SkipList *right)
+{
+    if (!left || !right || left == right)
+        return 0;
+
+    int ordered = !left->tail[0] || !right->header->forward[0] || left->tail[0]->key < right->header->forward[0]->key;
+    if (!ordered || left->arena != right->arena || left->compact != right->compact)
+    {
+        // Interleaved keys or nodes from another allocator: fall back to a linear merge,
+        // which leaves right untouched if it cannot start
+        skiplist_merge(left, right, SKIPLIST_TAKE_SOURCE);
+        return right->size == 0;
+    }
+    if (!grow_level_cap(left, left->size + right->size, right->level))
+        return 0;
+    int cut = right->header->forward[0] ? right->header->forward[0]->key : -1;
+
+    // Wheel and column first: these walk right's chain on its own. Right's nodes are
+    // only flagged as having a deadline, so theirs must all move or nothing may.
+    if (right->ttl)
+    {
+        if (!left->ttl)
+        {
+            left->ttl = right->ttl; // Same clock, so the wheel can simply change hands
+            right->ttl = NULL;
+        }
+        else if (!ttl_wheel_concat(left->ttl, right->ttl))
+        {
+            if (right->ttl->deadline_count > 0)
+                return 0;
+            fprintf(stderr, "Warning: could not queue every deadline; expired records stay hidden.\n");
+        }
+    }
+    if (left->column)
+    {
+        int ok = right->column ? column_concat(left->column, right->column) : 1;
+        for (SkipListNode *node = right->column ? NULL : right->header->forward[0]; node && ok; node = node->forward[0])
+        {
+            ok = column_insert(left->column, node->key, skiplist_record(right, node)->value); // Appends
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Warning: could not grow value column, disabling it.\n");
+            column_destroy(left->column);
+            left->column = NULL;
+        }
+    }
+
+    // Hang right's chains off left's tails
+    for (int i = 0; i <= right->level; i++)
+    {
+        if (!right->header->forward[i])
+            continue;
+        (left->tail[i] ? left->tail[i] : left->header)->forward[i] = right->header->forward[i];
+        left->tail[i] = right->tail[i];
+        if (i > left->level)
+            left->level = i;
+    }
+    for (int i = 0; i < MAX_LEVEL; i++)
+    {
+        left->level_counts[i] += right->level_counts[i];
+    }
+    left->size += right->size;
+
+    if (left->filter)
+    {
+        int ok = 1;
+        for (SkipListNode *node = right->header->forward[0]; node && ok; node = node->forward[0])
+        {
+            ok = cuckoo_insert(left->filter, node->key);
+        }
+        if (!ok || cuckoo_needs_growth(left->filter))
+            rebuild_filter(left);
+    }
+    if (left->deterministic && cut >= 0)
+        repair_cut(left, cut); // After the walks above: nodes that change height move
+
+    // right now owns nothing
+    SkipListNode *last[MAX_LEVEL];
+    begin_relink(right, last);
+    finish_relink(right, last);
+    ttl_wheel_destroy(right->ttl);
+    right->ttl = NULL;
+    refresh_components(right);
+    return 1;
+}
+
+double skiplist_observed_p(SkipList *list)
+{
+    if (!list || list->size == 0)
+        return 0.0;
+    return (double)(list->size - list->level_counts[0]) / (double)list->size;
+}
+
+// Bytes malloc spends on a block beyond what was asked for
+static size_t malloc_overhead(void *ptr, size_t requested)
+{
+#ifdef __GLIBC__
+    return malloc_usable_size(ptr) + sizeof(size_t) - requested; // Plus the chunk size word
+#else
+    (void)ptr;
+    size_t chunk = (requested + sizeof(size_t) + 15) / 16 * 16; // Typical 16-byte granularity
+    return (chunk < 32 ? 32 : chunk) - requested;
+#endif
+}
+
+void skiplist_memory(SkipList *list, SkipListMemory *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!list)
+        return;
+
+    size_t header_bytes = node_size(list->max_level - 1);
+    out->list = sizeof(SkipList) + header_bytes;
+    out->allocator = malloc_overhead(list, sizeof(SkipList)) + malloc_overhead(list->header, header_bytes);
+
+    for (SkipListNode *node = list->header->forward[0]; node; node = node->forward[0])
+    {
+        out->node_fields += sizeof(SkipListNode);
+        out->forward_pointers += sizeof(SkipListNode *) * (size_t)(node->level + 1);
+        if (!list->compact)
+            out->node_fields += sizeof(Record *);
+        out->records += sizeof(Record);
+        if (!list->arena)
+        {
+            out->allocator += malloc_overhead(node, data_node_size(list, node->level));
+            if (!list->compact)
+                out->allocator += malloc_overhead(skiplist_record(list, node), sizeof(Record));
+        }
+    }
+
+    if (list->arena)
+    {
+        // Everything mapped but not holding a node or record: rounding, free lists, chunk tails,
+        // and the other owners' nodes if the arena is shared
+        ArenaStats stats;
+        arena_get_stats(list->arena, &stats);
+        size_t unused = stats.bytes_mapped - (out->node_fields + out->forward_pointers + out->records);
+        if (arena_shared(list->arena))
+            out->shared_arena = unused;
+        else
+            out->allocator += unused;
+    }
+
+    out->cache = list->cache ? cache_bytes(list->cache) : 0;
+    out->filter = list->filter ? cuckoo_bytes(list->filter) : 0;
+    out->column = list->column ? column_bytes(list->column) : 0;
+    out->ttl = list->ttl ? ttl_wheel_bytes(list->ttl) : 0;
+    out->total = out->list + out->node_fields + out->forward_pointers + out->records + out->allocator +
+                 out->cache + out->filter + out->column + out->ttl;
+}
+
+void free_skiplist(SkipList *list)
+{
+    if (!list)
+        return;
+
+    // With an arena every node and record goes away with its chunks, so skip the walk,
+    // unless a list split from this one still uses the arena and could reuse the memory
+    SkipListNode *current = (list->arena && !arena_shared(list->arena)) ? NULL : list->header->forward[0];
+    SkipListNode *next;
 
     // Traverse level 0 and free all nodes
     while (current)
     {
         next = current->forward[0];
-        // Free the associated Record data
-        if (current->value)
-        {
-            free(current->value);
-        }
-        // Free the node's forward array
-        free(current->forward);
-        // Free the node itself
-        free(current);
+        release_node(list, current);
         current = next;
     }
 
-    // Free the header node's forward array and the header node itself
-    free(list->header->forward);
-    free(list->header);
+    // Free the header node, the side structures and the arena
+    free_components(list);
     // Free the list structure
     free(list);
 }
@@ -2,44 +2,158 @@
 #define SKIPLIST_H
 
 #include "record.h"
+#include "arena.h"
+#include "cache.h"
+#include "cuckoo.h"
+#include "column.h"
+#include "ttl.h"
+#include <stdint.h>
 #include <stdlib.h> // size_t
 
 // --- Tunable Parameters ---
-// Maximum possible levels in the skip list (adjust based on expected N)
-// log_p(N). For p=0.5, log2(N). For N=millions (e.g., 2^24), ~24 levels needed.
-// Add some buffer. 32 is generally safe for large datasets.
-#define MAX_LEVEL 32
-// Probability factor for level generation (0.5 is common)
+// Absolute ceiling on levels. The list grows its own cap from its size
+// (log_{1/p}(N) + 1), so this only bounds the per-operation stack arrays.
+#define MAX_LEVEL 64
+// Level cap a new, empty list starts with
+#define SKIPLIST_MIN_LEVEL 4
+// Default probability factor for level generation (0.5 is common)
 #define SKIPLIST_P 0.5
+// Lookups skiplist_search_batch keeps in flight. Each waits on one prefetched node
+// while the others advance, so roughly this many cache misses overlap.
+#define SKIPLIST_BATCH_WIDTH 16
 // -------------------------
 
 // Forward declaration
 typedef struct SkipListNode SkipListNode;
 
 // Node structure for the skip list
+// The forward pointers are stored inline so a node is a single allocation. After them
+// comes the record itself (compact mode) or a pointer to it; see skiplist_record.
+// A deadline lives in the list's timing wheel, and only a flag marks nodes that have one.
 struct SkipListNode
 {
-    int key;                // The ID of the record (used for sorting/searching)
-    Record *value;          // Pointer to the actual data record
-    int level;              // Highest level this node participates in (0-based)
-    SkipListNode **forward; // Array of forward pointers
+    int key;                 // The ID of the record (used for sorting/searching)
+    int16_t level;           // Highest level this node participates in (0-based)
+    uint16_t flags;          // NODE_HAS_TTL
+    SkipListNode *forward[]; // Forward pointers (level + 1 entries), then the record slot
 };
 
+// The list's TTL table holds a deadline for the node's key
+#define NODE_HAS_TTL 0x1u
+
+// Options chosen at creation time
+typedef struct
+{
+    int use_arena;        // Allocate nodes and records from a dedicated arena
+    ArenaOptions arena;   // Page mode and NUMA node used when use_arena is set
+    double p;             // Level probability (0 < p < 1), SKIPLIST_P by default
+    size_t cache_entries; // Size of the hot-key lookaside cache (0 = no cache)
+    int use_filter;       // Keep a cuckoo filter to short-circuit searches for absent keys
+    int use_column;       // Keep a columnar copy of Record.value for aggregate queries
+    int compact;          // Embed each record in its node (one allocation per record)
+    int deterministic;    // Balance towers by the 1-2-3 gap rule instead of coin flips. With compact as
+                          // well, a record moves with its node, so an insert or delete invalidates every
+                          // Record* obtained earlier; look the key up again after any change.
+    unsigned int seed;    // Seed of the list's tower-height generator (0 = draw one from rand())
+} SkipListOptions;
+
+// Which record survives when both lists of a merge hold the same key
+typedef enum
+{
+    SKIPLIST_TAKE_SOURCE = 0, // The merged-in record replaces the existing one
+    SKIPLIST_KEEP_DEST        // The existing record stays; the merged-in one is dropped
+} SkipListConflict;
+
 // Skip list structure
 typedef struct
 {
-    SkipListNode *header; // Pointer to the header node
-    int level;            // Current highest level in the list (0-based)
-    size_t size;          // Number of elements in the list
+    SkipListNode *header;            // Pointer to the header node
+    int level;                       // Current highest level in the list (0-based)
+    size_t size;                     // Number of elements in the list
+    Arena *arena;                    // Backing store for nodes and records (NULL = malloc)
+    double p;                        // Level probability
+    int max_level;                   // Current cap on levels (header has this many pointers)
+    double grow_at;                  // Size at which max_level grows by one
+    size_t level_counts[MAX_LEVEL];  // Number of nodes whose top level is i
+    SkipListNode *tail[MAX_LEVEL];   // Last node on each level (NULL = header), the append finger
+    size_t append_hits;              // Inserts that took the append-at-end fast path
+    KeyCache *cache;                 // Lookaside cache consulted by search (NULL = off)
+    CuckooFilter *filter;            // Membership filter consulted by search (NULL = off)
+    ValueColumn *column;             // Columnar copy of values used by aggregates (NULL = off)
+    TtlWheel *ttl;                   // Deadlines of records with a TTL (NULL until the first one is set)
+    int compact;                     // Records live inside their nodes, after the forward pointers
+    int deterministic;               // 1-2-3 skip list: every gap holds 1 to 3 nodes (see skiplist.c)
+    uint32_t rng;                    // xorshift state for tower heights (never 0)
 } SkipList;
 
+// Bytes held by a list, by category (see skiplist_memory)
+typedef struct
+{
+    size_t list;             // SkipList struct and header node
+    size_t node_fields;      // key, level and flags of every data node, plus its record pointer unless compact
+    size_t forward_pointers; // Inline forward pointers of every data node
+    size_t records;          // Record payloads (inside the nodes in compact mode)
+    size_t allocator;        // Allocator rounding, bookkeeping and unused arena space
+    size_t cache;            // Lookaside cache
+    size_t filter;           // Cuckoo filter
+    size_t column;           // Columnar value copy
+    size_t ttl;              // Timing wheel
+    size_t total;            // Sum of the above
+    size_t shared_arena;     // Arena bytes not holding this list's nodes while a split list shares the
+                             // arena; they are not this list's alone, so not in allocator or total
+} SkipListMemory;
+
 // --- Function Prototypes ---
 
 // Core Skip List Operations
 SkipList *create_skiplist();
+SkipList *create_skiplist_ex(const SkipListOptions *opts); // NULL opts = defaults
+void skiplist_default_options(SkipListOptions *opts);
 Record *search_skiplist(SkipList *list, int search_key);
-int insert_skiplist(SkipList *list, int key, Record *value); // Returns 1 on success, 0 on duplicate
+// Looks up keys[0..n) into out[0..n) (NULL = not found), interleaving the descents
+// so their cache misses overlap. Same results as n search_skiplist calls, except that
+// expired records are only hidden here; the timing wheel reclaims them later.
+void skiplist_search_batch(SkipList *list, const int *keys, size_t n, Record **out);
+// Returns 1 on success, 0 on duplicate. The list takes ownership of value; in compact
+// mode it is copied into the node and freed, so use search_skiplist for the stored one.
+// value must come from create_record_in(list->arena, ...): the list frees it with
+// free_record_in, which would corrupt the arena if given a malloc'd record.
+int insert_skiplist(SkipList *list, int key, Record *value);
 int delete_skiplist(SkipList *list, int key);                // Returns 1 on success, 0 if not found
+int update_skiplist(SkipList *list, int key, const char *name, double value); // Returns 1 on success, 0 if not found
+int skiplist_promote(SkipList *list, int key);               // Raise a hot key's tower to the top level (not in deterministic mode)
+Record *skiplist_record(const SkipList *list, const SkipListNode *node);  // Record of a data node (not the header)
+time_t skiplist_deadline(const SkipList *list, const SkipListNode *node); // When a data node's record expires (0 = never)
+double skiplist_observed_p(SkipList *list);                  // Fraction of nodes that reached level 1
+void skiplist_memory(SkipList *list, SkipListMemory *out);   // Walks every node; meant for reporting
+// count/sum/min/max of Record.value over IDs in [lo, hi]. Values must be changed
+// through update_skiplist for the columnar copy to stay in sync. Records past
+// their TTL are counted until they are reclaimed.
+void skiplist_aggregate(SkipList *list, int lo, int hi, Aggregate *out);
+// Expiry. Expired records are hidden from search at once and reclaimed a few at a
+// time by insert/delete (or skiplist_reap), so memory stays bounded without a sweep.
+int skiplist_expire_at(SkipList *list, int key, time_t when); // when = 0 clears; returns 0 if not found
+long skiplist_ttl(SkipList *list, int key);                   // Seconds left, -1 = no TTL, -2 = not found
+size_t skiplist_reap(SkipList *list, size_t max);             // Reclaims up to max expired records
+// Set operations, each a single pass over level 0 of both lists that relinks the result
+// with the nodes' existing towers. Cache, filter and column are rebuilt afterwards.
+// A deterministic list is re-towered in one more pass. Split and concat only repair the
+// gaps along the cut, which moves O(log n) towers.
+// Merge moves src's nodes into dest (copying them if the lists' allocators or layouts
+// differ) and leaves src empty; returns the number of records taken from src.
+size_t skiplist_merge(SkipList *dest, SkipList *src, SkipListConflict policy);
+size_t skiplist_intersect(SkipList *list, const SkipList *other); // Keeps keys also in other; returns records removed
+size_t skiplist_subtract(SkipList *list, const SkipList *other);  // Drops keys found in other; returns records removed
+// Detaches every node with a key >= key into a new list, by cutting one forward pointer
+// per level. No node or record is copied: both lists share the arena, if any. Sizes are
+// recounted by walking the smaller side; a filter on the new list is built from its keys.
+// NULL on allocation failure, with list unchanged.
+SkipList *skiplist_split(SkipList *list, int key);
+// Appends right to left (the inverse of split) by linking left's tails to right's first
+// nodes, and leaves right empty. Every key of right must be above left's keys and both
+// must share an allocator; otherwise it falls back to skiplist_merge. Returns 1 on success,
+// 0 if right still holds its records.
+int skiplist_concat(SkipList *left, SkipList *right);
 void free_skiplist(SkipList *list);
 
 // Helper for debugging (optional)
@@ -1,11 +1,47 @@
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <unistd.h> // Included for potential future use, not strictly needed now
+#include <unistd.h> // getpid, usleep
+
+#include "skiplist.h"    // Needs access to skiplist operations
+#include "record.h"      // Needs access to Record definition and create_record
+#include "persistence.h" // The stress test saves and reloads its lists
+#include "replication.h" // ... and replays one thread's changes on a follower
+
+// --- perf stat Control ---
+// Under `perf stat -D -1 --control fifo:<ctl>,<ack>` (see `make bench-perf`), counters
+// are enabled only while a timer runs, so setup and prefill are not counted.
+// The fifo paths come from PERF_CTL_FIFO / PERF_ACK_FIFO; without them this is a no-op.
+static FILE* perf_ctl = NULL;
+static FILE* perf_ack = NULL;
+
+void perf_control_open(void) {
+    const char* ctl = getenv("PERF_CTL_FIFO");
+    const char* ack = getenv("PERF_ACK_FIFO");
+    if (!ctl) return;
+    perf_ctl = fopen(ctl, "w");
+    if (perf_ctl && ack) perf_ack = fopen(ack, "r");
+    if (!perf_ctl) perror("Warning: could not open perf control fifo");
+}
 
-#include "skiplist.h" // Needs access to skiplist operations
-#include "record.h"   // Needs access to Record definition and create_record
+void perf_control(const char* cmd) {
+    if (!perf_ctl) return;
+    fprintf(perf_ctl, "%s\n", cmd);
+    fflush(perf_ctl);
+    if (perf_ack) {
+        char reply[16];
+        if (!fgets(reply, sizeof(reply), perf_ack)) { // Wait until perf has applied it
+            fclose(perf_ack);
+            perf_ack = NULL;
+        }
+    }
+}
+// --- End perf stat Control ---
 
 // --- Timer Structure ---
 typedef struct {
@@ -14,11 +50,13 @@ typedef struct {
 } Timer;
 
 void start_timer(Timer* t) {
+    perf_control("enable");
     t->start = clock();
 }
 
 double stop_timer(Timer* t) {
     t->end = clock();
+    perf_control("disable");
     return ((double)(t->end - t->start)) / CLOCKS_PER_SEC;
 }
 // --- End Timer ---
@@ -153,6 +191,71 @@ void run_test_search(long n, long m) {
     free_skiplist(list);
 }
 
+// Same workload as run_test_search, but the M lookups go through skiplist_search_batch,
+// which overlaps their cache misses instead of taking them one after another
+void run_test_search_batch(long n, long m) {
+    if (n <= 0 || m <= 0) {
+        fprintf(stderr, "Error: N and M must be positive for search test.\n");
+        return;
+    }
+
+    SkipList* list = create_skiplist();
+    if (!list) { fprintf(stderr, "Fatal: Failed to create skiplist for test.\n"); return; }
+
+    // 1. Pre-fill the list with N records
+    char name_buf[MAX_NAME_LEN];
+    Record* rec;
+    long prefill_success = 0;
+    for (long i = 0; i < n; ++i) {
+        snprintf(name_buf, MAX_NAME_LEN, "Record_%ld", i);
+        rec = create_record((int)i, name_buf, (double)(i % 1000));
+        if (rec && insert_skiplist(list, (int)i, rec)) {
+             prefill_success++;
+        } else if (rec) {
+             free(rec);
+        }
+    }
+    if (prefill_success != n) {
+         fprintf(stderr, "Error: Pre-fill failed. Expected %ld records, inserted %ld.\n", n, prefill_success);
+         free_skiplist(list);
+         return;
+    }
+
+    // 2. Prepare M random IDs to search for (from 0 to N-1)
+    int* search_ids = (int*)malloc(sizeof(int) * m);
+    Record** results = (Record**)malloc(sizeof(Record*) * m);
+    if (!search_ids || !results) {
+        fprintf(stderr, "Fatal: Failed to allocate memory for search IDs.\n");
+        free(search_ids); free(results); free_skiplist(list); return;
+    }
+    for (long i = 0; i < m; ++i) {
+        search_ids[i] = rand() % n;
+    }
+
+    // 3. Perform the M searches as one batch and time them
+    Timer timer;
+    start_timer(&timer);
+    skiplist_search_batch(list, search_ids, (size_t)m, results);
+    double elapsed = stop_timer(&timer);
+
+    long found_count = 0;
+    for (long i = 0; i < m; ++i) {
+        if (results[i] && results[i]->id == search_ids[i]) found_count++;
+    }
+    if (found_count != m) {
+        fprintf(stderr, "Warning: batch search found %ld of %ld records.\n", found_count, m);
+    }
+
+    // 4. Print results
+    printf("test_type,N,M,total_time_s,avg_time_per_op_s\n"); // CSV Header
+    printf("search_batch,%ld,%ld,%.6f,%.9f\n", n, m, elapsed, elapsed / m);
+
+    // 5. Cleanup
+    free(results);
+    free(search_ids);
+    free_skiplist(list);
+}
+
 // Performs M deletions on a list pre-filled with N records (IDs 0 to N-1)
 void run_test_delete(long n, long m) {
     if (n <= 0 || m <= 0) { fprintf(stderr, "Error: N and M must be positive for delete test.\n"); return; }
@@ -226,10 +329,613 @@ void run_test_delete(long n, long m) {
 }
 
 
+// --- Stress Test ---
+// Drives random operation sequences against the skip list and a plain array indexed by
+// key (the reference), checking every result. Every STRESS_ROUND operations the whole
+// structure is checked level by level and every key is looked up, one at a time and
+// batched. Each thread cycles through all combinations of list options with its own
+// lists: a list is not thread-safe, but state accidentally shared between lists (or
+// with the allocator) shows up as corruption here or as a race under `make stress-tsan`.
+// Every few lists are saved, loaded back and checked, and then must fail to load once a
+// byte of the file is damaged. Thread 0 also publishes its changes to a follower thread,
+// which checks its copy whenever thread 0 finishes a list.
+// Lists are seeded from the threads' generators and nothing else reads rand(), so a seed
+// replays the same operations and towers for any number of threads. Only the moments at
+// which the follower receives a change vary from run to run.
+#define STRESS_KEYS 2048        // Keys are drawn from [0, STRESS_KEYS)
+#define STRESS_ROUND 500        // Operations between full checks
+#define STRESS_CONFIG_OPS 1000  // Operations per list before moving to the next option set
+#define STRESS_CONFIGS 64       // Option sets: one bit each for arena, compact, cache, filter, column, deterministic
+#define STRESS_BATCH 48         // Largest batched lookup
+#define STRESS_SAVE_EVERY 5     // Lists between save/load round trips (coprime with STRESS_CONFIGS)
+#define STRESS_SYNC_WAIT_MS 10000 // How long thread 0 waits for the follower to catch up
+#define STRESS_MAX_THREADS 64
+
+typedef struct {
+    char present[STRESS_KEYS];
+    char has_ttl[STRESS_KEYS];
+    double value[STRESS_KEYS];
+} RefMap;
+
+typedef struct StressFollower StressFollower;
+
+typedef struct {
+    unsigned int rng;   // xorshift state; rand() is shared by all threads
+    long ops;           // Operations to run
+    long done;
+    long checks;
+    long lists;         // Lists finished
+    int id;             // Thread index, used in file names
+    int config;         // Option set in use
+    int failed;
+    char what[160];     // First failure
+    Replicator* leader; // Thread 0: publishes every change to `follower` (NULL otherwise)
+    StressFollower* follower;
+} StressThread;
+
+// Replays the leader's changes in its own thread. When the leader finishes a list it
+// copies its reference into `expected` and sets `target` to its last sequence number;
+// once the follower has applied that change it checks its list and sets `checked`.
+struct StressFollower {
+    Replicator* repl;
+    SkipList* list;
+    SkipListOptions opts;
+    RefMap expected;
+    uint64_t target;    // Atomic: leader sequence number to check at (0 = none yet)
+    uint64_t checked;   // Atomic: last target checked
+    int stop;           // Atomic
+    StressThread state; // Failure report and check count
+};
+
+static unsigned int stress_rand(StressThread* t) {
+    unsigned int x = t->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return t->rng = x;
+}
+
+// Records the first failure of a thread; returns 0 so callers can `return stress_fail(...)`
+static int stress_fail(StressThread* t, const char* fmt, ...) {
+    if (!t->failed) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(t->what, sizeof(t->what), fmt, args);
+        va_end(args);
+        t->failed = 1;
+    }
+    return 0;
+}
+
+static void stress_options(SkipListOptions* opts, int config) {
+    skiplist_default_options(opts);
+    opts->use_arena = config & 1;
+    opts->compact = (config >> 1) & 1;
+    opts->cache_entries = (config & 4) ? 64 : 0; // Small, so entries are evicted and reused
+    opts->use_filter = (config >> 3) & 1;
+    opts->use_column = (config >> 4) & 1;
+    opts->deterministic = (config >> 5) & 1;
+}
+
+// Checks list, which should hold exactly the reference keys in [lo, hi): order, records,
+// sizes and per-level counts, that level i links exactly the nodes of level >= i, the
+// tail fingers, the 1-2-3 gap rule in deterministic mode, and every lookup path.
+static int check_list(SkipList* list, const RefMap* ref, int lo, int hi, StressThread* t) {
+    size_t counts[MAX_LEVEL] = {0};
+    size_t size = 0;
+    size_t with_ttl = 0;
+    int prev = -1;
+    SkipListNode* last = NULL;
+    for (SkipListNode* x = list->header->forward[0]; x; x = x->forward[0]) {
+        if (x->key <= prev) return stress_fail(t, "key %d follows key %d", x->key, prev);
+        if (x->key < lo || x->key >= hi || !ref->present[x->key]) return stress_fail(t, "unexpected key %d", x->key);
+        if (x->level < 0 || x->level > list->level)
+            return stress_fail(t, "key %d has level %d, list level is %d", x->key, x->level, list->level);
+        Record* rec = skiplist_record(list, x);
+        if (!rec || rec->id != x->key || rec->value != ref->value[x->key])
+            return stress_fail(t, "wrong record for key %d", x->key);
+        if ((x->flags & NODE_HAS_TTL) != (skiplist_deadline(list, x) != 0))
+            return stress_fail(t, "TTL flag of key %d does not match the deadline table", x->key);
+        with_ttl += (x->flags & NODE_HAS_TTL) != 0;
+        counts[x->level]++;
+        size++;
+        prev = x->key;
+        last = x;
+    }
+
+    size_t expected = 0;
+    for (int k = lo; k < hi; k++) expected += (size_t)ref->present[k];
+    if (size != expected || list->size != expected)
+        return stress_fail(t, "%lu nodes linked, size says %lu, expected %lu",
+                           (unsigned long)size, (unsigned long)list->size, (unsigned long)expected);
+    for (int i = 0; i < MAX_LEVEL; i++) {
+        if (counts[i] != list->level_counts[i])
+            return stress_fail(t, "level_counts[%d] is %lu, counted %lu", i,
+                               (unsigned long)list->level_counts[i], (unsigned long)counts[i]);
+    }
+    if (list->level < 0 || list->level >= list->max_level || (list->level > 0 && !list->header->forward[list->level]))
+        return stress_fail(t, "list level %d is not the highest used level", list->level);
+    if (list->tail[0] != last) return stress_fail(t, "tail finger of level 0 is stale");
+    if ((list->ttl ? list->ttl->deadline_count : 0) != with_ttl)
+        return stress_fail(t, "deadline table holds %lu keys, %lu nodes have a TTL",
+                           (unsigned long)(list->ttl ? list->ttl->deadline_count : 0), (unsigned long)with_ttl);
+
+    // memstats: the node categories match the walk, and a shared arena is not charged to one list
+    SkipListMemory mem;
+    skiplist_memory(list, &mem);
+    size_t live = size * sizeof(SkipListNode) + (list->compact ? 0 : size * sizeof(Record*)) + size * sizeof(Record);
+    for (int i = 0; i < MAX_LEVEL; i++) live += counts[i] * sizeof(SkipListNode*) * (size_t)(i + 1);
+    if (mem.node_fields + mem.forward_pointers + mem.records != live)
+        return stress_fail(t, "memstats counts %lu node bytes, walked %lu",
+                           (unsigned long)(mem.node_fields + mem.forward_pointers + mem.records), (unsigned long)live);
+    if (mem.total != mem.list + live + mem.allocator + mem.cache + mem.filter + mem.column + mem.ttl)
+        return stress_fail(t, "memstats total is not the sum of its categories");
+    if (list->arena) {
+        ArenaStats st;
+        arena_get_stats(list->arena, &st);
+        if (mem.shared_arena != (arena_shared(list->arena) ? st.bytes_mapped - live : 0))
+            return stress_fail(t, "memstats splits the %s arena wrongly", arena_shared(list->arena) ? "shared" : "private");
+    } else if (mem.shared_arena != 0) {
+        return stress_fail(t, "memstats reports a shared arena without one");
+    }
+
+    for (int i = 1; i < list->max_level; i++) {
+        // Level i must link exactly the nodes of level >= i, in level-0 order
+        SkipListNode* z = list->header->forward[0];
+        SkipListNode* tail = NULL;
+        for (SkipListNode* x = list->header->forward[i]; x; x = x->forward[i]) {
+            while (z && z->level < i) z = z->forward[0];
+            if (z != x) return stress_fail(t, "level %d links key %d out of place", i, x->key);
+            tail = x;
+            z = z->forward[0];
+        }
+        while (z && z->level < i) z = z->forward[0];
+        if (z) return stress_fail(t, "level %d misses key %d", i, z->key);
+        if (list->tail[i] != tail) return stress_fail(t, "tail finger of level %d is stale", i);
+    }
+
+    if (list->deterministic && size > 0) {
+        // Every node taller than i (and the header) owns 1 to 3 nodes of exactly level i
+        for (int i = 0; i <= list->level; i++) {
+            for (SkipListNode* o = list->header; o; o = (i < list->level) ? o->forward[i + 1] : NULL) {
+                int gap = 0;
+                for (SkipListNode* x = o->forward[i]; x && x->level == i; x = x->forward[i]) gap++;
+                if (gap < 1 || gap > 3)
+                    return stress_fail(t, "gap of %d nodes on level %d after key %d", gap, i,
+                                       o == list->header ? -1 : o->key);
+            }
+        }
+    }
+
+    int keys[STRESS_KEYS];
+    Record* found[STRESS_KEYS];
+    for (int k = 0; k < STRESS_KEYS; k++) {
+        int expect = k >= lo && k < hi && ref->present[k];
+        Record* rec = search_skiplist(list, k);
+        if ((rec != NULL) != expect || (rec && rec->id != k)) return stress_fail(t, "search for %d is wrong", k);
+        if (expect && (skiplist_ttl(list, k) > 0) != ref->has_ttl[k]) return stress_fail(t, "TTL of %d is wrong", k);
+        keys[k] = k;
+    }
+    skiplist_search_batch(list, keys, STRESS_KEYS, found);
+    for (int k = 0; k < STRESS_KEYS; k++) {
+        int expect = k >= lo && k < hi && ref->present[k];
+        if ((found[k] != NULL) != expect || (found[k] && found[k]->id != k))
+            return stress_fail(t, "batched search for %d is wrong", k);
+    }
+
+    Aggregate agg;
+    double sum = 0.0;
+    skiplist_aggregate(list, 0, STRESS_KEYS, &agg);
+    for (int k = lo; k < hi; k++) {
+        if (ref->present[k]) sum += ref->value[k];
+    }
+    if (agg.count != expected || agg.sum != sum) return stress_fail(t, "aggregate over the whole list is wrong");
+    t->checks++;
+    return 1;
+}
+
+// Thread 0 only: queues a change to key for the follower, as main.c does after a command
+static void stress_publish(StressThread* t, SkipList* list, ReplOpKind op, int key, time_t expires_at) {
+    if (!t->leader) return;
+    Record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.id = key;
+    if (op == REPL_OP_ADD || op == REPL_OP_UPDATE) {
+        Record* current = search_skiplist(list, key);
+        if (current) rec = *current;
+    }
+    repl_publish(t->leader, op, &rec, expires_at);
+}
+
+// Merges, intersects or subtracts a random second list. The second list sometimes uses
+// another layout or allocator, so nodes are copied instead of moved.
+static int stress_set_op(SkipList* list, RefMap* ref, StressThread* t) {
+    SkipListOptions opts;
+    skiplist_default_options(&opts);
+    opts.compact = (stress_rand(t) & 3) ? list->compact : !list->compact;
+    opts.use_arena = stress_rand(t) & 1;
+    opts.deterministic = stress_rand(t) & 1;
+    opts.seed = stress_rand(t);
+    SkipList* other = create_skiplist_ex(&opts);
+    if (!other) return stress_fail(t, "out of memory");
+
+    char in_other[STRESS_KEYS];
+    char other_ttl[STRESS_KEYS] = {0};
+    double other_value[STRESS_KEYS];
+    size_t other_size = 0;
+    for (int k = 0; k < STRESS_KEYS; k++) {
+        in_other[k] = (stress_rand(t) % 8) == 0;
+        other_value[k] = (double)(stress_rand(t) % 1000);
+        if (!in_other[k]) continue;
+        Record* rec = create_record_in(other->arena, k, "other", other_value[k]);
+        if (!rec || !insert_skiplist(other, k, rec)) {
+            if (rec) free_record_in(other->arena, rec);
+            free_skiplist(other);
+            return stress_fail(t, "could not build the second list");
+        }
+        other_size++;
+    }
+    // Some duplicates of live keys are expired but not reclaimed yet: they must count as
+    // absent and must not take the existing record with them. Others keep a TTL.
+    time_t now = time(NULL);
+    for (SkipListNode* x = other->header->forward[0]; x; x = x->forward[0]) {
+        unsigned int pick = stress_rand(t) % 8;
+        if (pick < 3 && !skiplist_expire_at(other, x->key, now + 3600)) {
+            free_skiplist(other);
+            return stress_fail(t, "could not set a TTL on the second list");
+        }
+        if (pick < 2 && ref->present[x->key]) {
+            ttl_wheel_set_deadline(other->ttl, x->key, now - 1); // Back-dated: replaces the entry, cannot fail
+            in_other[x->key] = 0;
+        }
+        other_ttl[x->key] = pick < 3;
+    }
+
+    unsigned int kind = stress_rand(t) % 4;
+    size_t expected = 0;
+    for (int k = 0; k < STRESS_KEYS; k++) {
+        if (kind == 0) expected += (size_t)in_other[k];                       // Every record is taken
+        else if (kind == 1) expected += (size_t)(in_other[k] && !ref->present[k]); // Only new keys
+        else if (kind == 2) expected += (size_t)(ref->present[k] && !in_other[k]); // Removed by intersect
+        else expected += (size_t)(ref->present[k] && in_other[k]);             // Removed by subtract
+    }
+
+    size_t result;
+    if (kind < 2) result = skiplist_merge(list, other, kind == 0 ? SKIPLIST_TAKE_SOURCE : SKIPLIST_KEEP_DEST);
+    else if (kind == 2) result = skiplist_intersect(list, other);
+    else result = skiplist_subtract(list, other);
+    int emptied = other->size == 0 && other->header->forward[0] == NULL;
+    free_skiplist(other);
+
+    static const char* const names[] = {"merge (take)", "merge (keep)", "intersect", "subtract"};
+    if (result != expected)
+        return stress_fail(t, "%s returned %lu, expected %lu", names[kind], (unsigned long)result, (unsigned long)expected);
+    if (kind < 2 && !emptied && other_size > 0) return stress_fail(t, "%s left records in the source", names[kind]);
+
+    for (int k = 0; k < STRESS_KEYS; k++) {
+        if (kind < 2 && in_other[k] && (kind == 0 || !ref->present[k])) {
+            ref->present[k] = 1;
+            ref->has_ttl[k] = other_ttl[k]; // The deadline comes along
+            ref->value[k] = other_value[k];
+        } else if ((kind == 2 && !in_other[k]) || (kind == 3 && in_other[k])) {
+            ref->present[k] = 0;
+        }
+    }
+    return 1;
+}
+
+// Splits at a random key, checks both halves and joins them again, in order or (as a
+// merge) the other way round
+static int stress_split(SkipList** listp, RefMap* ref, StressThread* t) {
+    SkipList* list = *listp;
+    int key = (int)(stress_rand(t) % (STRESS_KEYS + 1));
+    SkipList* upper = skiplist_split(list, key);
+    if (!upper) return stress_fail(t, "split at %d failed", key);
+    if (!check_list(list, ref, 0, key, t) || !check_list(upper, ref, key, STRESS_KEYS, t)) {
+        free_skiplist(upper);
+        return 0;
+    }
+
+    int ok;
+    if (stress_rand(t) & 1) {
+        ok = skiplist_concat(list, upper);
+        free_skiplist(upper);
+    } else {
+        ok = skiplist_concat(upper, list);
+        free_skiplist(list);
+        *listp = upper;
+    }
+    return ok ? 1 : stress_fail(t, "concat after split at %d failed", key);
+}
+
+// Runs one random operation and checks its result against the reference
+static int stress_step(SkipList** listp, RefMap* ref, StressThread* t) {
+    SkipList* list = *listp;
+    int k = (int)(stress_rand(t) % STRESS_KEYS);
+    double v = (double)(stress_rand(t) % 1000);
+    unsigned int op = stress_rand(t) % 100;
+
+    if (op < 30) {
+        Record* rec = create_record_in(list->arena, k, "stress", v);
+        if (!rec) return stress_fail(t, "out of memory");
+        int ok = insert_skiplist(list, k, rec);
+        if (ok != !ref->present[k]) return stress_fail(t, "insert %d returned %d", k, ok);
+        if (!ok) {
+            free_record_in(list->arena, rec);
+        } else {
+            ref->present[k] = 1;
+            ref->has_ttl[k] = 0;
+            ref->value[k] = v;
+            stress_publish(t, list, REPL_OP_ADD, k, 0);
+        }
+    } else if (op < 45) {
+        int ok = delete_skiplist(list, k);
+        if (ok != ref->present[k]) return stress_fail(t, "delete %d returned %d", k, ok);
+        if (ok) stress_publish(t, list, REPL_OP_DEL, k, 0);
+        ref->present[k] = 0;
+    } else if (op < 55) {
+        int ok = update_skiplist(list, k, "updated", v);
+        if (ok != ref->present[k]) return stress_fail(t, "update %d returned %d", k, ok);
+        if (ok) {
+            ref->value[k] = v;
+            stress_publish(t, list, REPL_OP_UPDATE, k, 0);
+        }
+    } else if (op < 70) {
+        Record* rec = search_skiplist(list, k);
+        if ((rec != NULL) != ref->present[k] || (rec && (rec->id != k || rec->value != ref->value[k])))
+            return stress_fail(t, "search for %d is wrong", k);
+    } else if (op < 75) {
+        int keys[STRESS_BATCH];
+        Record* found[STRESS_BATCH];
+        size_t n = 1 + stress_rand(t) % STRESS_BATCH;
+        for (size_t i = 0; i < n; i++) keys[i] = (int)(stress_rand(t) % STRESS_KEYS); // Repeats allowed
+        skiplist_search_batch(list, keys, n, found);
+        for (size_t i = 0; i < n; i++) {
+            int key = keys[i];
+            if ((found[i] != NULL) != ref->present[key] || (found[i] && found[i]->value != ref->value[key]))
+                return stress_fail(t, "batched search for %d is wrong", key);
+        }
+    } else if (op < 80) {
+        // Clear, set far ahead, or set in the past (which deletes at once)
+        unsigned int kind = stress_rand(t) % 4;
+        time_t now = time(NULL);
+        time_t when = kind == 0 ? 0 : kind == 1 ? now + 3600 : now - 1;
+        int ok = skiplist_expire_at(list, k, when);
+        if (ok != ref->present[k]) return stress_fail(t, "expire %d returned %d", k, ok);
+        if (ok) stress_publish(t, list, REPL_OP_EXPIRE, k, when);
+        if (ok && kind >= 2) ref->present[k] = 0;
+        else if (ok) ref->has_ttl[k] = (kind == 1);
+    } else if (op < 82) {
+        int ok = skiplist_promote(list, k);
+        if (ok != (ref->present[k] && !list->deterministic)) return stress_fail(t, "promote %d returned %d", k, ok);
+    } else if (op < 85) {
+        int lo = k;
+        int hi = lo + (int)(stress_rand(t) % 256);
+        Aggregate agg;
+        size_t count = 0;
+        double sum = 0.0;
+        skiplist_aggregate(list, lo, hi, &agg);
+        for (int key = lo; key <= hi && key < STRESS_KEYS; key++) {
+            if (ref->present[key]) {
+                count++;
+                sum += ref->value[key];
+            }
+        }
+        if (agg.count != count || agg.sum != sum) return stress_fail(t, "aggregate over [%d, %d] is wrong", lo, hi);
+    } else if (op < 88) {
+        if (!stress_set_op(list, ref, t)) return 0;
+        if (t->leader) repl_snapshot_all(t->leader, list); // Many keys changed at once
+    } else if (op < 90) {
+        if (!stress_split(listp, ref, t)) return 0;
+        if (t->leader) repl_snapshot_all(t->leader, *listp);
+    } else {
+        // A run of keys past the largest one takes the append path
+        int start = list->tail[0] ? list->tail[0]->key + 1 : k;
+        for (int key = start; key < start + 8 && key < STRESS_KEYS; key++) {
+            Record* rec = create_record_in(list->arena, key, "append", v);
+            if (!rec || !insert_skiplist(list, key, rec)) return stress_fail(t, "append of %d failed", key);
+            ref->present[key] = 1;
+            ref->has_ttl[key] = 0;
+            ref->value[key] = v;
+            stress_publish(t, list, REPL_OP_ADD, key, 0);
+        }
+    }
+    return 1;
+}
+
+static const char* stress_tmpdir(void) {
+    const char* dir = getenv("TMPDIR");
+    return (dir && *dir) ? dir : "/tmp";
+}
+
+// Saves list, loads it back with the same options and checks the copy, TTLs included.
+// Then damages one byte of the file, which the checksum must reject.
+static int stress_round_trip(SkipList* list, const RefMap* ref, const SkipListOptions* opts, StressThread* t) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/crud_stress_%d_%d.bin", stress_tmpdir(), (int)getpid(), t->id);
+    if (!save_database_ex(list, path, NULL)) return stress_fail(t, "save to %s failed", path);
+
+    SkipList* loaded = load_database_ex(path, opts, NULL);
+    int ok = loaded ? check_list(loaded, ref, 0, STRESS_KEYS, t) : stress_fail(t, "could not load %s", path);
+    free_skiplist(loaded);
+
+    FILE* file = ok ? fopen(path, "r+b") : NULL;
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        long at = (long)(stress_rand(t) % (unsigned long)ftell(file));
+        fseek(file, at, SEEK_SET);
+        int byte = fgetc(file);
+        fseek(file, at, SEEK_SET);
+        fputc(byte ^ 0x5A, file);
+        fclose(file);
+        loaded = load_database_ex(path, opts, NULL);
+        if (loaded) {
+            free_skiplist(loaded);
+            ok = stress_fail(t, "%s loaded with byte %ld damaged", path, at);
+        }
+    } else if (ok) {
+        ok = stress_fail(t, "could not reopen %s", path);
+    }
+    remove(path);
+    return ok;
+}
+
+// Thread 0: waits until the follower has applied every change so far and checked its
+// copy against ref
+static int stress_sync_follower(SkipList** listp, const RefMap* ref, StressThread* t) {
+    StressFollower* f = t->follower;
+    // A change to a key that is never present, so the target is past any snapshot
+    // (snapshots carry the sequence number of the change before them)
+    stress_publish(t, *listp, REPL_OP_DEL, STRESS_KEYS, 0);
+    memcpy(&f->expected, ref, sizeof(RefMap));
+    uint64_t target = t->leader->seq;
+    __atomic_store_n(&f->target, target, __ATOMIC_RELEASE);
+
+    for (int waited = 0; __atomic_load_n(&f->checked, __ATOMIC_ACQUIRE) != target; waited++) {
+        if (waited >= STRESS_SYNC_WAIT_MS)
+            return stress_fail(t, "follower did not reach seq %llu", (unsigned long long)target);
+        repl_service(t->leader, listp, NULL); // Flushes, and accepts the follower when it connects
+        usleep(1000);
+    }
+    return f->state.failed ? stress_fail(t, "follower: %s", f->state.what) : 1;
+}
+
+static void* stress_follower(void* arg) {
+    StressFollower* f = (StressFollower*)arg;
+    uint64_t checked = 0;
+    while (!__atomic_load_n(&f->stop, __ATOMIC_ACQUIRE)) {
+        struct pollfd pfd = {repl_poll_fd(f->repl), POLLIN, 0};
+        poll(&pfd, 1, 10); // A negative fd is ignored, so this also paces reconnects
+        repl_service(f->repl, &f->list, &f->opts);
+
+        uint64_t target = __atomic_load_n(&f->target, __ATOMIC_ACQUIRE);
+        if (target != checked && f->repl->synced && f->repl->seq == target) {
+            check_list(f->list, &f->expected, 0, STRESS_KEYS, &f->state);
+            checked = target;
+            __atomic_store_n(&f->checked, target, __ATOMIC_RELEASE);
+        }
+    }
+    return NULL;
+}
+
+static void* stress_thread(void* arg) {
+    StressThread* t = (StressThread*)arg;
+    RefMap* ref = (RefMap*)malloc(sizeof(RefMap));
+    if (!ref) {
+        stress_fail(t, "out of memory");
+        return NULL;
+    }
+
+    while (t->done < t->ops && !t->failed) {
+        SkipListOptions opts;
+        stress_options(&opts, t->config);
+        opts.seed = stress_rand(t);
+        SkipList* list = create_skiplist_ex(&opts);
+        if (!list) {
+            stress_fail(t, "could not create a list");
+            break;
+        }
+        memset(ref, 0, sizeof(RefMap));
+        if (t->leader) repl_snapshot_all(t->leader, list); // The follower starts over too
+
+        for (long i = 1; i <= STRESS_CONFIG_OPS && t->done < t->ops; i++) {
+            t->done++;
+            if (!stress_step(&list, ref, t)) break;
+            repl_service(t->leader, &list, NULL); // Sends this step's changes (no-op without a leader)
+            if (i % STRESS_ROUND == 0 && !check_list(list, ref, 0, STRESS_KEYS, t)) break;
+        }
+        if (!t->failed) check_list(list, ref, 0, STRESS_KEYS, t);
+        if (!t->failed && ++t->lists % STRESS_SAVE_EVERY == 0) stress_round_trip(list, ref, &opts, t);
+        if (!t->failed && t->follower) stress_sync_follower(&list, ref, t);
+        free_skiplist(list);
+        if (!t->failed) t->config = (t->config + 1) % STRESS_CONFIGS;
+    }
+    free(ref);
+    return NULL;
+}
+
+// Runs ops random operations on each of `threads` threads. Returns 0 if every result and
+// every structure check matched the reference, 1 otherwise.
+int run_test_stress(long ops, int threads, unsigned int seed) {
+    if (ops <= 0 || threads <= 0 || threads > STRESS_MAX_THREADS) {
+        fprintf(stderr, "Error: ops must be positive and threads between 1 and %d.\n", STRESS_MAX_THREADS);
+        return 1;
+    }
+
+    StressThread states[STRESS_MAX_THREADS];
+    pthread_t ids[STRESS_MAX_THREADS];
+    memset(states, 0, sizeof(states));
+
+    // Thread 0's follower, on a socket of its own; it keeps every optional component on
+    StressFollower follower;
+    pthread_t follower_id;
+    char socket_path[108];
+    memset(&follower, 0, sizeof(follower));
+    stress_options(&follower.opts, STRESS_CONFIGS - 1);
+    follower.opts.seed = seed + 1;
+    snprintf(socket_path, sizeof(socket_path), "%s/crud_stress_%d.sock", stress_tmpdir(), (int)getpid());
+    Replicator* leader = repl_leader_create(socket_path);
+    follower.repl = leader ? repl_follower_create(socket_path) : NULL;
+    follower.list = create_skiplist_ex(&follower.opts);
+    if (!follower.repl || !follower.list || pthread_create(&follower_id, NULL, stress_follower, &follower) != 0) {
+        fprintf(stderr, "Error: could not start the replication follower on %s.\n", socket_path);
+        repl_destroy(follower.repl);
+        repl_destroy(leader);
+        free_skiplist(follower.list);
+        return 1;
+    }
+    states[0].leader = leader;
+    states[0].follower = &follower;
+
+    Timer timer;
+    start_timer(&timer);
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        unsigned int rng = (seed + 1) * 0x9E3779B9u ^ (unsigned int)(i + 1) * 0x85EBCA6Bu;
+        states[i].rng = rng ? rng : 1; // xorshift needs a non-zero state
+        states[i].id = i;
+        states[i].ops = ops;
+        states[i].config = (i * STRESS_CONFIGS) / threads; // Threads start on different option sets
+        if (pthread_create(&ids[i], NULL, stress_thread, &states[i]) != 0) {
+            stress_fail(&states[i], "could not start thread");
+            break;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) pthread_join(ids[i], NULL);
+    double elapsed = stop_timer(&timer);
+    __atomic_store_n(&follower.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(follower_id, NULL);
+    long follower_checks = follower.state.checks;
+    repl_destroy(follower.repl); // First, so the leader's last sends fail instead of blocking
+    repl_destroy(leader);
+    free_skiplist(follower.list);
+
+    int failures = 0;
+    long checks = 0;
+    for (int i = 0; i < threads; i++) {
+        checks += states[i].checks;
+        if (states[i].failed) {
+            SkipListOptions opts;
+            stress_options(&opts, states[i].config);
+            fprintf(stderr, "FAIL (seed %u, thread %d, operation %ld; arena=%d compact=%d cache=%d filter=%d column=%d deterministic=%d): %s\n",
+                    seed, i, states[i].done, opts.use_arena, opts.compact, opts.cache_entries > 0,
+                    opts.use_filter, opts.use_column, opts.deterministic, states[i].what);
+            failures++;
+        }
+    }
+    if (failures > 0) return 1;
+
+    printf("Stress test passed: %ld operations on %d thread(s), %ld full checks (%ld on the follower), seed %u (%.3f s CPU).\n",
+           ops * threads, threads, checks, follower_checks, seed, elapsed);
+    return 0;
+}
+
 // --- Main Function for Testing ---
 int main(int argc, char *argv[]) {
     // Seed random number generator (important for shuffle and skiplist level)
     srand((unsigned int)time(NULL));
+    perf_control_open();
 
     // Argument Parsing for Test Modes
     if (argc < 3) { // Need at least program name and test type
@@ -237,7 +943,9 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "Usage:\n");
         fprintf(stderr, "  %s --test-insert <N>\n", argv[0]);
         fprintf(stderr, "  %s --test-search <N> <M>\n", argv[0]);
+        fprintf(stderr, "  %s --test-search-batch <N> <M>\n", argv[0]);
         fprintf(stderr, "  %s --test-delete <N> <M>\n", argv[0]);
+        fprintf(stderr, "  %s --test-stress <ops> <threads> [seed]\n", argv[0]);
         return 1;
     }
 
@@ -250,11 +958,22 @@ int main(int argc, char *argv[]) {
         long n = atol(argv[2]);
         long m = atol(argv[3]);
         run_test_search(n, m);
+    } else if (strcmp(argv[1], "--test-search-batch") == 0) {
+        if (argc != 4) goto usage;
+        long n = atol(argv[2]);
+        long m = atol(argv[3]);
+        run_test_search_batch(n, m);
     } else if (strcmp(argv[1], "--test-delete") == 0) {
          if (argc != 4) goto usage;
         long n = atol(argv[2]);
         long m = atol(argv[3]);
         run_test_delete(n, m);
+    } else if (strcmp(argv[1], "--test-stress") == 0) {
+        if (argc != 4 && argc != 5) goto usage;
+        long ops = atol(argv[2]);
+        int threads = atoi(argv[3]);
+        unsigned int seed = (argc == 5) ? (unsigned int)strtoul(argv[4], NULL, 10) : (unsigned int)time(NULL);
+        return run_test_stress(ops, threads, seed);
     } else {
         fprintf(stderr, "Error: Unknown test type '%s'\n", argv[1]);
         goto usage;
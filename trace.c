@@ -0,0 +1,133 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *phase_names[TRACE_PHASES] = {"parse", "lookup", "alloc", "persist", "replicate", "output"};
+
+uint64_t trace_now_ns(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    struct timespec ts; // No monotonic clock (e.g. MSVC): wall time is the best there is
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+Tracer *trace_create(void)
+{
+    Tracer *tracer = (Tracer *)calloc(1, sizeof(Tracer));
+    if (!tracer)
+        return NULL;
+    tracer->events = (TraceEvent *)malloc(TRACE_RING_EVENTS * sizeof(TraceEvent));
+    if (!tracer->events)
+    {
+        free(tracer);
+        return NULL;
+    }
+    return tracer;
+}
+
+void trace_destroy(Tracer *tracer)
+{
+    if (!tracer)
+        return;
+    free(tracer->events);
+    free(tracer);
+}
+
+// Stores an event, overwriting the oldest once the ring is full
+static void record(Tracer *tracer, int phase, uint64_t start, uint64_t end, const char *name)
+{
+    TraceEvent *e = &tracer->events[tracer->next];
+    e->start_ns = start;
+    e->dur_ns = end - start;
+    e->command = tracer->commands;
+    e->phase = (uint8_t)phase;
+    size_t len = 0;
+    for (; name && name[len] && len < TRACE_NAME_LEN - 1; len++)
+    {
+        // Anything the JSON dump would have to escape is replaced
+        e->name[len] = (name[len] == '"' || name[len] == '\\' || (unsigned char)name[len] < 0x20) ? '?' : name[len];
+    }
+    e->name[len] = '\0';
+
+    tracer->next = (tracer->next + 1) % TRACE_RING_EVENTS;
+    if (tracer->count < TRACE_RING_EVENTS)
+        tracer->count++;
+}
+
+void trace_command_begin(Tracer *tracer)
+{
+    if (!tracer || !tracer->enabled)
+        return;
+    tracer->commands++;
+    tracer->open = 1;
+    tracer->phase = TRACE_PARSE;
+    tracer->command_start = tracer->phase_start = trace_now_ns();
+}
+
+void trace_phase(Tracer *tracer, TracePhase phase)
+{
+    if (!tracer || !tracer->open || phase == tracer->phase)
+        return;
+    uint64_t now = trace_now_ns();
+    uint64_t dur = now - tracer->phase_start;
+    tracer->phase_total_ns[tracer->phase] += dur;
+    if (dur > tracer->phase_max_ns[tracer->phase])
+        tracer->phase_max_ns[tracer->phase] = dur;
+    record(tracer, tracer->phase, tracer->phase_start, now, NULL);
+    tracer->phase = phase;
+    tracer->phase_start = now;
+}
+
+void trace_command_end(Tracer *tracer, const char *name)
+{
+    if (!tracer || !tracer->open)
+        return;
+    trace_phase(tracer, TRACE_PHASES); // Closes the running phase
+    record(tracer, TRACE_PHASES, tracer->command_start, tracer->phase_start, name);
+    tracer->open = 0;
+}
+
+int trace_dump_chrome(const Tracer *tracer, const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+        return 0;
+
+    // Complete ("X") events on one thread; a command encloses its phases, so the
+    // viewer nests them. Timestamps are microseconds.
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    size_t first = (tracer->next + TRACE_RING_EVENTS - tracer->count) % TRACE_RING_EVENTS;
+    for (size_t i = 0; i < tracer->count; i++)
+    {
+        const TraceEvent *e = &tracer->events[(first + i) % TRACE_RING_EVENTS];
+        int command = e->phase == TRACE_PHASES;
+        fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"pid\":1,\"tid\":1,\"args\":{\"command\":%u}}\n",
+                i ? "," : "", command ? e->name : phase_names[e->phase], command ? "command" : "phase",
+                (double)e->start_ns / 1000.0, (double)e->dur_ns / 1000.0, (unsigned)e->command);
+    }
+    fprintf(fp, "]}\n");
+    return fclose(fp) == 0;
+}
+
+void print_trace_stats(const Tracer *tracer)
+{
+    printf("Tracing: %s, %u commands traced, %lu events in the ring (capacity %d).\n",
+           tracer->enabled ? "on" : "off", (unsigned)tracer->commands, (unsigned long)tracer->count,
+           TRACE_RING_EVENTS);
+    if (tracer->commands == 0)
+        return;
+    printf("  Phase      Total ms   Avg us/cmd   Max us\n");
+    for (int p = 0; p < TRACE_PHASES; p++)
+    {
+        printf("  %-9s %9.3f %12.3f %8.3f\n", phase_names[p], (double)tracer->phase_total_ns[p] / 1e6,
+               (double)tracer->phase_total_ns[p] / 1e3 / tracer->commands, (double)tracer->phase_max_ns[p] / 1e3);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h> // size_t
+#include <stdint.h>
+
+// --- Tunable Parameters ---
+// Phase events kept in the ring; the oldest are overwritten once it is full
+#define TRACE_RING_EVENTS 65536
+// Command name length kept per event (longer names are cut)
+#define TRACE_NAME_LEN 12
+// -------------------------
+
+// Where the time of a command goes. Every command starts in TRACE_PARSE; each
+// trace_phase call ends the running phase and starts the next one.
+typedef enum
+{
+    TRACE_PARSE = 0, // Reading arguments out of the input line
+    TRACE_LOOKUP,    // Skip list operations
+    TRACE_ALLOC,     // Creating records
+    TRACE_PERSIST,   // Saving or loading files
+    TRACE_REPLICATE, // Queueing changes for followers
+    TRACE_OUTPUT,    // Printing results
+    TRACE_PHASES
+} TracePhase;
+
+// One finished phase (or, with phase == TRACE_PHASES, a whole command)
+typedef struct
+{
+    uint64_t start_ns;
+    uint64_t dur_ns;
+    uint32_t command;            // Sequence number of the command it belongs to
+    uint8_t phase;               // TracePhase
+    char name[TRACE_NAME_LEN];   // Command name
+} TraceEvent;
+
+// Per-command phase timings, recorded with a monotonic clock into a ring buffer
+typedef struct
+{
+    TraceEvent *events;          // Ring of TRACE_RING_EVENTS events
+    size_t next;                 // Slot the next event goes into
+    size_t count;                // Events held (at most TRACE_RING_EVENTS)
+    uint32_t commands;           // Commands traced so far
+    int enabled;                 // Recording; when off every call returns at once
+    int open;                    // A command is being traced
+    TracePhase phase;            // Phase running in the open command
+    uint64_t phase_start;
+    uint64_t command_start;
+    uint64_t phase_total_ns[TRACE_PHASES]; // Time per phase over every traced command
+    uint64_t phase_max_ns[TRACE_PHASES];   // Longest single phase
+} Tracer;
+
+uint64_t trace_now_ns(void); // Monotonic clock
+Tracer *trace_create(void);  // Starts disabled; NULL on allocation failure
+void trace_destroy(Tracer *tracer);
+
+// All of these accept a NULL or disabled tracer and then do nothing
+void trace_command_begin(Tracer *tracer);                  // Input line read; parsing starts
+void trace_phase(Tracer *tracer, TracePhase phase);        // Ends the running phase, starts this one
+void trace_command_end(Tracer *tracer, const char *name);  // Ends the command (no-op if none is open)
+
+// Writes the ring as Chrome trace JSON (chrome://tracing, Perfetto). Returns 0 on failure.
+int trace_dump_chrome(const Tracer *tracer, const char *path);
+void print_trace_stats(const Tracer *tracer);
+
+#endif // TRACE_H
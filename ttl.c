@@ -0,0 +1,296 @@
+#include "ttl.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// --- Deadline Table ---
+
+// First slot to probe for key (the table is non-empty)
+static size_t home_slot(const TtlWheel *wheel, int key)
+{
+    return (size_t)((uint32_t)key * 2654435761u) & (wheel->deadline_cap - 1);
+}
+
+// Slot holding key, or the free slot where it would go
+static size_t find_slot(const TtlWheel *wheel, int key)
+{
+    size_t i = home_slot(wheel, key);
+    while (wheel->deadlines[i].expires_at != 0 && wheel->deadlines[i].key != key)
+    {
+        i = (i + 1) & (wheel->deadline_cap - 1);
+    }
+    return i;
+}
+
+// Makes room for `extra` more keys at no more than half load. Returns 0 on
+// allocation failure, with the table unchanged.
+static int reserve_deadlines(TtlWheel *wheel, size_t extra)
+{
+    if (extra == 0)
+        return 1;
+    size_t cap = wheel->deadline_cap ? wheel->deadline_cap : 16;
+    while ((wheel->deadline_count + extra) * 2 > cap)
+    {
+        cap *= 2;
+    }
+    if (cap == wheel->deadline_cap)
+        return 1;
+
+    TtlEntry *old = wheel->deadlines;
+    size_t old_cap = wheel->deadline_cap;
+    TtlEntry *table = (TtlEntry *)calloc(cap, sizeof(TtlEntry));
+    if (!table)
+        return 0;
+    wheel->deadlines = table;
+    wheel->deadline_cap = cap;
+    for (size_t i = 0; i < old_cap; i++)
+    {
+        if (old[i].expires_at != 0)
+            table[find_slot(wheel, old[i].key)] = old[i];
+    }
+    free(old);
+    return 1;
+}
+
+int ttl_wheel_set_deadline(TtlWheel *wheel, int key, time_t expires_at)
+{
+    // Replacing a deadline never needs room
+    if (ttl_wheel_deadline(wheel, key) == 0 && !reserve_deadlines(wheel, 1))
+        return 0;
+    TtlEntry *e = &wheel->deadlines[find_slot(wheel, key)];
+    if (e->expires_at == 0)
+        wheel->deadline_count++;
+    e->key = key;
+    e->expires_at = expires_at;
+    return 1;
+}
+
+time_t ttl_wheel_deadline(const TtlWheel *wheel, int key)
+{
+    if (!wheel || wheel->deadline_count == 0)
+        return 0;
+    return wheel->deadlines[find_slot(wheel, key)].expires_at;
+}
+
+void ttl_wheel_clear_deadline(TtlWheel *wheel, int key)
+{
+    if (!wheel || wheel->deadline_count == 0)
+        return;
+    size_t mask = wheel->deadline_cap - 1;
+    size_t hole = find_slot(wheel, key);
+    if (wheel->deadlines[hole].expires_at == 0)
+        return;
+    wheel->deadline_count--;
+
+    // Backward-shift deletion: pull later entries of the run into the hole when their
+    // home slot does not lie between the hole and them, so no tombstones are needed
+    for (size_t i = (hole + 1) & mask; wheel->deadlines[i].expires_at != 0; i = (i + 1) & mask)
+    {
+        size_t home = home_slot(wheel, wheel->deadlines[i].key);
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            wheel->deadlines[hole] = wheel->deadlines[i];
+            hole = i;
+        }
+    }
+    wheel->deadlines[hole].expires_at = 0;
+}
+
+// --- Wheel ---
+
+TtlWheel *ttl_wheel_create(time_t now)
+{
+    TtlWheel *wheel = (TtlWheel *)calloc(1, sizeof(TtlWheel));
+    if (!wheel)
+        return NULL;
+    wheel->cursor = now;
+    return wheel;
+}
+
+int ttl_wheel_add(TtlWheel *wheel, int key, time_t expires_at)
+{
+    // A deadline already behind the cursor goes into the slot being drained
+    time_t when = expires_at < wheel->cursor ? wheel->cursor : expires_at;
+    TtlSlot *slot = &wheel->slots[(size_t)when & (TTL_WHEEL_SLOTS - 1)];
+
+    if (slot->count == slot->cap)
+    {
+        size_t cap = slot->cap ? slot->cap * 2 : 4;
+        TtlEntry *entries = (TtlEntry *)realloc(slot->entries, cap * sizeof(TtlEntry));
+        if (!entries)
+            return 0;
+        slot->entries = entries;
+        slot->cap = cap;
+    }
+
+    slot->entries[slot->count].key = key;
+    slot->entries[slot->count].expires_at = expires_at;
+    slot->count++;
+    wheel->pending++;
+    return 1;
+}
+
+size_t ttl_wheel_expire(TtlWheel *wheel, time_t now, int *out, size_t max)
+{
+    size_t found = 0;
+    size_t budget = max * TTL_SCAN_FACTOR;
+
+    if (wheel->pending == 0)
+    {
+        // Nothing queued: catch the cursor up instead of stepping through empty slots
+        if (wheel->cursor <= now)
+            wheel->cursor = now + 1;
+        wheel->scan = 0;
+        return 0;
+    }
+
+    while (wheel->cursor <= now && found < max && budget > 0)
+    {
+        TtlSlot *slot = &wheel->slots[(size_t)wheel->cursor & (TTL_WHEEL_SLOTS - 1)];
+        while (wheel->scan < slot->count && found < max && budget > 0)
+        {
+            TtlEntry *e = &slot->entries[wheel->scan];
+            budget--;
+            if (e->expires_at <= now)
+            {
+                out[found++] = e->key;
+                *e = slot->entries[--slot->count]; // Unordered: fill the hole from the end
+                wheel->pending--;
+            }
+            else
+            {
+                wheel->scan++; // Due on a later turn of the wheel
+            }
+        }
+        if (wheel->scan < slot->count)
+            break; // Out of budget mid-slot; resume here next time
+
+        if (slot->count == 0 && slot->cap > 16)
+        {
+            // Give back memory left over from a burst of deadlines
+            free(slot->entries);
+            slot->entries = NULL;
+            slot->cap = 0;
+        }
+        wheel->cursor++;
+        wheel->scan = 0;
+        if (budget > 0)
+            budget--; // Stepping to the next slot counts as work too
+    }
+    return found;
+}
+
+TtlWheel *ttl_wheel_split(TtlWheel *wheel, int key)
+{
+    TtlWheel *upper = ttl_wheel_create(wheel->cursor);
+    if (!upper)
+        return NULL;
+
+    // Deadlines are copied first, into a table sized up front; they leave wheel's
+    // table only once everything else has moved too
+    size_t moving = 0;
+    for (size_t i = 0; i < wheel->deadline_cap; i++)
+    {
+        moving += (size_t)(wheel->deadlines[i].expires_at != 0 && wheel->deadlines[i].key >= key);
+    }
+    if (!reserve_deadlines(upper, moving))
+    {
+        ttl_wheel_destroy(upper);
+        return NULL;
+    }
+    for (size_t i = 0; i < wheel->deadline_cap; i++)
+    {
+        if (wheel->deadlines[i].expires_at != 0 && wheel->deadlines[i].key >= key)
+            ttl_wheel_set_deadline(upper, wheel->deadlines[i].key, wheel->deadlines[i].expires_at);
+    }
+
+    for (size_t i = 0; i < TTL_WHEEL_SLOTS; i++)
+    {
+        TtlSlot *slot = &wheel->slots[i];
+        for (size_t e = 0; e < slot->count;)
+        {
+            if (slot->entries[e].key < key)
+            {
+                e++;
+                continue;
+            }
+            if (!ttl_wheel_add(upper, slot->entries[e].key, slot->entries[e].expires_at))
+            {
+                // Put back what moved: the freed slots have room, and wheel still
+                // holds every deadline, so none needs a new table slot
+                ttl_wheel_concat(wheel, upper);
+                ttl_wheel_destroy(upper);
+                return NULL;
+            }
+            slot->entries[e] = slot->entries[--slot->count];
+            wheel->pending--;
+        }
+    }
+    wheel->scan = 0; // The cursor's slot was reordered; rescanning it is harmless
+
+    for (size_t i = 0; i < upper->deadline_cap; i++)
+    {
+        if (upper->deadlines[i].expires_at != 0)
+            ttl_wheel_clear_deadline(wheel, upper->deadlines[i].key);
+    }
+    return upper;
+}
+
+int ttl_wheel_concat(TtlWheel *dst, TtlWheel *src)
+{
+    // Deadlines first, all or nothing: dst is sized for the keys it does not have yet
+    size_t extra = 0;
+    for (size_t i = 0; i < src->deadline_cap; i++)
+    {
+        if (src->deadlines[i].expires_at != 0 && ttl_wheel_deadline(dst, src->deadlines[i].key) == 0)
+            extra++;
+    }
+    if (!reserve_deadlines(dst, extra))
+        return 0;
+    for (size_t i = 0; i < src->deadline_cap; i++)
+    {
+        if (src->deadlines[i].expires_at != 0)
+            ttl_wheel_set_deadline(dst, src->deadlines[i].key, src->deadlines[i].expires_at);
+    }
+    free(src->deadlines);
+    src->deadlines = NULL;
+    src->deadline_cap = 0;
+    src->deadline_count = 0;
+
+    for (size_t i = 0; i < TTL_WHEEL_SLOTS; i++)
+    {
+        TtlSlot *slot = &src->slots[i];
+        while (slot->count > 0)
+        {
+            TtlEntry *e = &slot->entries[slot->count - 1];
+            if (!ttl_wheel_add(dst, e->key, e->expires_at))
+                return 0;
+            slot->count--;
+            src->pending--;
+        }
+    }
+    dst->expired += src->expired;
+    src->expired = 0;
+    return 1;
+}
+
+size_t ttl_wheel_bytes(const TtlWheel *wheel)
+{
+    size_t bytes = sizeof(TtlWheel) + wheel->deadline_cap * sizeof(TtlEntry);
+    for (size_t i = 0; i < TTL_WHEEL_SLOTS; i++)
+    {
+        bytes += wheel->slots[i].cap * sizeof(TtlEntry);
+    }
+    return bytes;
+}
+
+void ttl_wheel_destroy(TtlWheel *wheel)
+{
+    if (!wheel)
+        return;
+    for (size_t i = 0; i < TTL_WHEEL_SLOTS; i++)
+    {
+        free(wheel->slots[i].entries);
+    }
+    free(wheel->deadlines);
+    free(wheel);
+}
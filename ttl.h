@@ -0,0 +1,67 @@
+#ifndef TTL_H
+#define TTL_H
+
+#include <stddef.h> // size_t
+#include <time.h>   // time_t
+
+// --- Tunable Parameters ---
+// Wheel slots, one per second (power of two). Deadlines further out than this
+// share a slot with nearer ones and are simply skipped until their turn comes.
+#define TTL_WHEEL_SLOTS 256
+// Expired records reclaimed per list operation
+#define TTL_REAP_PER_OP 8
+// Wheel entries (or empty slots) examined per expired record asked for
+#define TTL_SCAN_FACTOR 4
+// -------------------------
+
+// A deadline queued on the wheel, or a key's entry in the deadline table. The table is
+// authoritative: wheel entries left behind by a delete or a changed TTL are dropped
+// when reached.
+typedef struct
+{
+    int key;
+    time_t expires_at;
+} TtlEntry;
+
+typedef struct
+{
+    TtlEntry *entries;
+    size_t count;
+    size_t cap;
+} TtlSlot;
+
+// Hashed timing wheel of record deadlines, plus the current deadline of every key that
+// has one, so nodes need not carry an expiry field
+typedef struct
+{
+    TtlSlot slots[TTL_WHEEL_SLOTS];
+    time_t cursor;          // Second whose slot is being drained; earlier seconds are done
+    size_t scan;            // Position reached within the cursor's slot
+    size_t pending;         // Entries on the wheel, stale ones included
+    size_t expired;         // Records reclaimed because their TTL ran out
+    TtlEntry *deadlines;    // Open-addressed table, linear probing (expires_at 0 = free slot)
+    size_t deadline_cap;    // Table slots (power of two, 0 = not allocated)
+    size_t deadline_count;  // Keys with a deadline
+} TtlWheel;
+
+TtlWheel *ttl_wheel_create(time_t now);
+int ttl_wheel_add(TtlWheel *wheel, int key, time_t expires_at); // Returns 0 on allocation failure
+// Deadline table. set records (or replaces) key's deadline; it does not queue it on the
+// wheel. Returns 0 on allocation failure, with the table unchanged.
+int ttl_wheel_set_deadline(TtlWheel *wheel, int key, time_t expires_at);
+time_t ttl_wheel_deadline(const TtlWheel *wheel, int key); // 0 = none
+void ttl_wheel_clear_deadline(TtlWheel *wheel, int key);
+// Moves up to max keys whose deadline is <= now into out[], examining at most
+// max * TTL_SCAN_FACTOR entries or slots. Returns the number of keys written.
+size_t ttl_wheel_expire(TtlWheel *wheel, time_t now, int *out, size_t max);
+// Moves the entries and deadlines for keys >= key into a new wheel at the same position.
+// NULL on allocation failure, with wheel unchanged.
+TtlWheel *ttl_wheel_split(TtlWheel *wheel, int key);
+// Moves every entry and deadline of src onto dst, leaving src empty. Returns 0 on
+// allocation failure: if src still has deadlines nothing moved, otherwise only some
+// wheel entries stayed behind in src.
+int ttl_wheel_concat(TtlWheel *dst, TtlWheel *src);
+size_t ttl_wheel_bytes(const TtlWheel *wheel);
+void ttl_wheel_destroy(TtlWheel *wheel);
+
+#endif // TTL_H